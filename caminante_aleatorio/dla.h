@@ -0,0 +1,276 @@
+#ifndef DLA_H
+#define DLA_H
+
+/*
+ * Agregacion limitada por difusion en la red cuadrada.
+ *
+ * Cada particula sale de un punto uniforme del circulo de lanzamiento (radio
+ * del cumulo + LANZAMIENTO) y camina con pasos de red hasta quedar junto a un
+ * sitio ocupado, donde se pega. Dos atajos evitan casi todos los pasos:
+ *
+ *   - Mapa de ocupacion por niveles: la celda (i, j) del nivel k dice si hay
+ *     algun sitio ocupado en el bloque de 2^k x 2^k que cubre. Si el bloque
+ *     del caminante y sus 8 vecinos del nivel k estan vacios, no hay nada a
+ *     menos de 2^k + 1 y el caminante salta a un punto uniforme del circulo
+ *     de radio 2^k - 1 (el primer paso por ese circulo de un movimiento
+ *     browniano). Lejos del cumulo los saltos son del tamano del hueco.
+ *   - Fuera del circulo de lanzamiento el caminante regresa a el de un solo
+ *     salto: desde radio r el punto donde lo toca por primera vez tiene
+ *     distribucion de Cauchy envuelta con rho = R / r alrededor de su angulo,
+ *     y en dos dimensiones siempre regresa, asi que no hace falta matarlo.
+ *
+ * En paralelo se lanzan rondas de particulas contra el cumulo como estaba al
+ * empezar la ronda; al final se pegan en orden de particula y la que cae en
+ * un sitio ya tomado en la misma ronda se vuelve a lanzar en la siguiente con
+ * su mismo generador. El tamano de la ronda solo depende del tamano del
+ * cumulo (1/256 de el), asi que el cumulo no depende de los hilos.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "../comun/aleatorio.h"
+
+#define NIVELES_DLA 12
+#define LANZAMIENTO 5
+#define RONDA_MAXIMA 4096
+#define DIRECCIONES_DLA 4096
+
+typedef struct {
+	Generador generador;
+	int64_t x, y;           // donde se pego, en la red
+} Particula;
+
+typedef struct {
+	int bits;                               // la red es de 2^bits x 2^bits
+	long lado;
+	uint8_t *niveles[NIVELES_DLA];          // niveles[0] es la red misma
+	double coseno[DIRECCIONES_DLA], seno[DIRECCIONES_DLA];
+	int64_t radio;                          // el sitio ocupado mas lejano del centro
+	long particulas, maximo;
+	int64_t *x, *y;                         // sitios en orden de llegada
+	double suma_x, suma_y, suma_r2;         // para el radio de giro
+
+	// Ronda en curso
+	Particula *ronda;
+	long en_ronda;
+	atomic_long siguiente;
+	unsigned long long semilla;
+	long lanzadas;                          // flujo de la proxima particula nueva
+} Dla;
+
+static inline uint8_t *dla_celda(const Dla *d, int k, int64_t x, int64_t y){
+	return &d->niveles[k][(y >> k) * (d->lado >> k) + (x >> k)];
+}
+
+// El bloque del nivel k de (x, y) y sus 8 vecinos estan vacios.
+static inline int dla_vacio(const Dla *d, int k, int64_t x, int64_t y){
+	long lado = d->lado >> k;
+	int64_t i = x >> k, j = y >> k;
+	if (i < 1 || j < 1 || i >= lado - 1 || j >= lado - 1)
+		return 0;
+	const uint8_t *c = d->niveles[k] + (j - 1) * lado + i;
+	return !(c[-1] | c[0] | c[1] | c[lado - 1] | c[lado] | c[lado + 1] |
+	         c[2 * lado - 1] | c[2 * lado] | c[2 * lado + 1]);
+}
+
+static inline int dla_vecino(const Dla *d, int64_t x, int64_t y){
+	const uint8_t *c = dla_celda(d, 0, x, y);
+	return c[-1] | c[1] | c[-d->lado] | c[d->lado];
+}
+
+void dla_liberar(Dla *d){
+	for (int k = 0; k < NIVELES_DLA; k++)
+		free(d->niveles[k]);
+	free(d->x);
+	free(d->y);
+	free(d->ronda);
+}
+
+static void dla_pegar(Dla *d, int64_t x, int64_t y){
+	for (int k = 0; k < NIVELES_DLA; k++)
+		*dla_celda(d, k, x, y) = 1;
+	int64_t cx = x - d->lado / 2, cy = y - d->lado / 2;
+	int64_t r = (int64_t)ceil(sqrt((double)(cx * cx + cy * cy)));
+	if (r > d->radio)
+		d->radio = r;
+	d->x[d->particulas] = cx;
+	d->y[d->particulas] = cy;
+	d->particulas++;
+	d->suma_x += cx;
+	d->suma_y += cy;
+	d->suma_r2 += (double)(cx * cx + cy * cy);
+}
+
+/*
+ * Red de 2^bits de lado con una semilla en el centro y lugar para 'maximo'
+ * particulas. Devuelve -1 si falta memoria.
+ */
+int dla_iniciar(Dla *d, int bits, long maximo, unsigned long long semilla){
+	memset(d, 0, sizeof(*d));
+	d->bits = bits;
+	d->lado = 1L << bits;
+	d->maximo = maximo;
+	d->semilla = semilla;
+	for (int k = 0; k < NIVELES_DLA; k++)
+		d->niveles[k] = calloc((size_t)(d->lado >> k) * (d->lado >> k), 1);
+	d->x = malloc(maximo * sizeof(int64_t));
+	d->y = malloc(maximo * sizeof(int64_t));
+	d->ronda = malloc(RONDA_MAXIMA * sizeof(Particula));
+	if (d->niveles[NIVELES_DLA - 1] == NULL || d->niveles[0] == NULL || d->x == NULL ||
+	    d->y == NULL || d->ronda == NULL) {
+		dla_liberar(d);
+		return -1;
+	}
+	for (int k = 1; k < NIVELES_DLA - 1; k++)
+		if (d->niveles[k] == NULL) {
+			dla_liberar(d);
+			return -1;
+		}
+	for (int k = 0; k < DIRECCIONES_DLA; k++) {
+		d->coseno[k] = cos(2 * M_PI * k / DIRECCIONES_DLA);
+		d->seno[k] = sin(2 * M_PI * k / DIRECCIONES_DLA);
+	}
+	dla_pegar(d, d->lado / 2, d->lado / 2);
+	return 0;
+}
+
+// Punto de la red mas cercano al circulo de radio r y angulo 2 pi u.
+static inline void dla_circulo(double cx, double cy, double r, double u, int64_t *x, int64_t *y){
+	*x = (int64_t)floor(cx + r * cos(2 * M_PI * u) + 0.5);
+	*y = (int64_t)floor(cy + r * sin(2 * M_PI * u) + 0.5);
+}
+
+/*
+ * Camina la particula p desde el circulo de lanzamiento hasta que queda junto
+ * al cumulo (que no cambia durante la ronda) y deja ahi su sitio.
+ */
+static void dla_caminar(const Dla *d, Particula *p){
+	const double centro = d->lado / 2;
+	const double lanzamiento = d->radio + LANZAMIENTO;
+	Generador *g = &p->generador;
+	int64_t x, y;
+	dla_circulo(centro, centro, lanzamiento, generador_uniforme(g), &x, &y);
+
+	uint64_t bits = 0;
+	int quedan = 0;
+	for (;;) {
+		double rx = x - centro, ry = y - centro, r2 = rx * rx + ry * ry;
+		if (r2 > (lanzamiento + 1) * (lanzamiento + 1)) {
+			// Regreso al circulo con la Cauchy envuelta
+			double r = sqrt(r2), rho = lanzamiento / r;
+			double u = generador_uniforme(g);
+			double giro = 2 * atan((1 - rho) / (1 + rho) * tan(M_PI * (u - 0.5)));
+			double angulo = atan2(ry, rx) + giro;
+			x = (int64_t)floor(centro + lanzamiento * cos(angulo) + 0.5);
+			y = (int64_t)floor(centro + lanzamiento * sin(angulo) + 0.5);
+			continue;
+		}
+
+		// Salto tan grande como el hueco vacio mas grande alrededor
+		int k = 1;
+		while (k + 1 < NIVELES_DLA && dla_vacio(d, k + 1, x, y))
+			k++;
+		if (k >= 2) {
+			double salto = (double)((1 << k) - 1);
+			int a = generador_u64(g) >> (64 - 12);
+			x += (int64_t)floor(salto * d->coseno[a] + 0.5);
+			y += (int64_t)floor(salto * d->seno[a] + 0.5);
+			continue;
+		}
+
+		if (dla_vecino(d, x, y)) {
+			p->x = x;
+			p->y = y;
+			return;
+		}
+		if (quedan == 0) {
+			bits = generador_u64(g);
+			quedan = 32;
+		}
+		switch (bits & 3) {
+		case 0: x++; break;
+		case 1: x--; break;
+		case 2: y++; break;
+		case 3: y--; break;
+		}
+		bits >>= 2;
+		quedan--;
+	}
+}
+
+static void *dla_hilo(void *arg){
+	Dla *d = arg;
+	for (long i; (i = atomic_fetch_add(&d->siguiente, 1)) < d->en_ronda; )
+		dla_caminar(d, &d->ronda[i]);
+	return NULL;
+}
+
+/*
+ * Agrega particulas hasta tener 'particulas' o hasta que el cumulo llega a
+ * 2^NIVELES_DLA de la orilla de la red (devuelve 1). 'avance' se llama tras
+ * cada ronda si no es NULL.
+ */
+int dla_crecer(Dla *d, long particulas, int hilos, void (*avance)(const Dla *)){
+	pthread_t *ids = malloc(hilos * sizeof(pthread_t));
+	long pendientes = 0;        // rechazadas que esperan al inicio de d->ronda
+	int lleno = 0;
+	if (particulas > d->maximo)
+		particulas = d->maximo;
+
+	while (d->particulas < particulas) {
+		if (d->radio + LANZAMIENTO + 3 * (1L << (NIVELES_DLA - 1)) >= d->lado / 2) {
+			lleno = 1;
+			break;
+		}
+		long tamano = d->particulas / 256;
+		if (tamano < 1)
+			tamano = 1;
+		if (tamano > RONDA_MAXIMA)
+			tamano = RONDA_MAXIMA;
+		if (tamano > particulas - d->particulas)
+			tamano = particulas - d->particulas;
+		if (tamano < pendientes)
+			tamano = pendientes;
+		for (long i = pendientes; i < tamano; i++)
+			generador_iniciar(&d->ronda[i].generador, d->semilla, d->lanzadas++);
+		d->en_ronda = tamano;
+		atomic_init(&d->siguiente, 0);
+
+		int usados = ids == NULL ? 0 : (tamano < hilos ? (int)tamano : hilos);
+		for (int h = 0; h < usados; h++)
+			pthread_create(&ids[h], NULL, dla_hilo, d);
+		if (usados == 0)
+			dla_hilo(d);
+		for (int h = 0; h < usados; h++)
+			pthread_join(ids[h], NULL);
+
+		// Se pegan en orden; las que chocan se recorren al inicio de la ronda
+		pendientes = 0;
+		for (long i = 0; i < tamano; i++) {
+			Particula *p = &d->ronda[i];
+			if (*dla_celda(d, 0, p->x, p->y) || d->particulas >= particulas)
+				d->ronda[pendientes++] = *p;
+			else
+				dla_pegar(d, p->x, p->y);
+		}
+		if (d->particulas >= particulas)
+			pendientes = 0;
+		if (avance != NULL)
+			avance(d);
+	}
+	free(ids);
+	return lleno;
+}
+
+// Radio de giro del cumulo.
+double dla_giro(const Dla *d){
+	double mx = d->suma_x / d->particulas, my = d->suma_y / d->particulas;
+	double r2 = d->suma_r2 / d->particulas - mx * mx - my * my;
+	return r2 > 0 ? sqrt(r2) : 0;
+}
+
+#endif
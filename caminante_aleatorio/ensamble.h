@@ -0,0 +1,185 @@
+#ifndef ENSAMBLE_H
+#define ENSAMBLE_H
+
+/*
+ * Muchos caminantes a la vez, sin ventana.
+ *
+ * Los caminantes se reparten en grupos de GRUPO_CAMINANTES guardados como
+ * estructura de arreglos (x[], y[] y el estado de un xoshiro256** por
+ * caminante), y cada grupo da todos sus pasos antes de pasar al siguiente:
+ * asi su estado completo cabe en cache y el ciclo sobre los caminantes de un
+ * grupo se vectoriza. El grupo g siempre se siembra con el flujo g de la
+ * semilla, de modo que el resultado no depende de cuantos hilos se usen.
+ *
+ * Los pasos salen del nucleo de la distribucion escogida (pasos.h).
+ *
+ * Por paso se suma r^2 de todos los caminantes (desplazamiento cuadratico
+ * medio) y al final se guarda la distancia de cada uno a su origen. Con la
+ * frontera absorbente (frontera.h) esto es solo de los que siguen activos, y
+ * de cada absorbido se guarda el paso en que salio.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "pasos.h"
+#include "frontera.h"
+
+typedef struct {
+	long caminantes, pasos;
+	unsigned long long semilla;
+	int hilos;
+	const Pasos *distribucion;  // de donde sale cada paso
+	const Frontera *frontera;
+	atomic_long siguiente;      // proximo grupo sin simular
+	double *msd;                // msd[t] = promedio de r^2 tras t + 1 pasos
+	long *vivos;                // vivos[t] = activos tras t + 1 pasos
+	double *distancias;         // distancia final de cada sobreviviente
+	double *tiempos;            // paso en que se absorbio cada absorbido
+	long sobrevivientes, absorbidos;
+	pthread_mutex_t candado;
+} Ensamble;
+
+/*
+ * Cada hilo toma grupos hasta que se acaban. El MSD y los activos se acumulan
+ * en arreglos propios y se suman al total una sola vez al terminar.
+ *
+ * Las distancias y los tiempos del grupo k van en los lugares del grupo
+ * (desde k GRUPO_CAMINANTES), en el orden en que salen; los que sobran quedan
+ * en NAN y ensamble_simular los quita al final.
+ */
+void *ensamble_hilo(void *arg){
+	Ensamble *e = arg;
+	Grupo *g = aligned_alloc(64, sizeof(Grupo));
+	double *msd = calloc(e->pasos, sizeof(double));
+	long *vivos = calloc(e->pasos, sizeof(long));
+	int64_t *fuera = malloc(GRUPO_CAMINANTES * sizeof(int64_t));
+	long grupos = (e->caminantes + GRUPO_CAMINANTES - 1) / GRUPO_CAMINANTES;
+
+	if (g == NULL || msd == NULL || vivos == NULL || fuera == NULL) {
+		free(g);
+		free(msd);
+		free(vivos);
+		free(fuera);
+		return (void *)1;
+	}
+
+	for (long k; (k = atomic_fetch_add(&e->siguiente, 1)) < grupos; ) {
+		long primero = k * GRUPO_CAMINANTES;
+		int n = e->caminantes - primero < GRUPO_CAMINANTES ? (int)(e->caminantes - primero)
+		                                                   : GRUPO_CAMINANTES;
+		int activos = n, absorbidos = 0;
+		grupo_iniciar(g, e->semilla, k);
+		for (long t = 0; t < e->pasos && activos > 0; t++) {
+			e->distribucion->grupo(e->distribucion, g, activos);
+			if (e->frontera->tipo != LIBRE &&
+			    frontera_grupo(e->frontera, g, activos, fuera) && e->frontera->tipo == ABSORBENTE) {
+				int antes = activos;
+				frontera_retirar(g, &activos, fuera);
+				for (; antes > activos; antes--)
+					e->tiempos[primero + absorbidos++] = t + 1;
+			}
+			msd[t] += grupo_r2(g, activos);
+			vivos[t] += activos;
+		}
+		for (int i = 0; i < n; i++) {
+			e->distancias[primero + i] = i < activos ? sqrt(g->x[i] * g->x[i] + g->y[i] * g->y[i]) : NAN;
+			if (i >= absorbidos)
+				e->tiempos[primero + i] = NAN;
+		}
+	}
+
+	pthread_mutex_lock(&e->candado);
+	for (long t = 0; t < e->pasos; t++) {
+		e->msd[t] += msd[t];
+		e->vivos[t] += vivos[t];
+	}
+	pthread_mutex_unlock(&e->candado);
+
+	free(g);
+	free(msd);
+	free(vivos);
+	free(fuera);
+	return NULL;
+}
+
+void ensamble_liberar(Ensamble *e){
+	free(e->msd);
+	free(e->vivos);
+	free(e->distancias);
+	free(e->tiempos);
+}
+
+// Quita los NAN de datos[0 .. n) sin cambiar el orden; devuelve cuantos quedan.
+static long ensamble_compactar(double *datos, long n){
+	long m = 0;
+	for (long i = 0; i < n; i++)
+		if (!isnan(datos[i]))
+			datos[m++] = datos[i];
+	return m;
+}
+
+/*
+ * Simula 'caminantes' caminantes de 'pasos' pasos, tomados de 'distribucion',
+ * con 'hilos' hilos, dentro de 'frontera'. Deja en e->msd el desplazamiento
+ * cuadratico medio tras cada paso, en e->distancias la distancia final de los
+ * e->sobrevivientes y en e->tiempos el tiempo de primer paso de los
+ * e->absorbidos. Devuelve -1 si falta memoria.
+ */
+int ensamble_simular(Ensamble *e, const Pasos *distribucion, const Frontera *frontera,
+                     long caminantes, long pasos, int hilos, unsigned long long semilla){
+	e->distribucion = distribucion;
+	e->frontera = frontera;
+	e->caminantes = caminantes;
+	e->pasos = pasos;
+	e->hilos = hilos;
+	e->semilla = semilla;
+	atomic_init(&e->siguiente, 0);
+	e->msd = calloc(pasos, sizeof(double));
+	e->vivos = calloc(pasos, sizeof(long));
+	e->distancias = malloc(caminantes * sizeof(double));
+	e->tiempos = malloc(caminantes * sizeof(double));
+	pthread_t *ids = malloc(hilos * sizeof(pthread_t));
+	if (e->msd == NULL || e->vivos == NULL || e->distancias == NULL || e->tiempos == NULL ||
+	    ids == NULL) {
+		ensamble_liberar(e);
+		free(ids);
+		return -1;
+	}
+
+	int error = 0;
+	pthread_mutex_init(&e->candado, NULL);
+	for (int h = 0; h < hilos; h++)
+		pthread_create(&ids[h], NULL, ensamble_hilo, e);
+	for (int h = 0; h < hilos; h++) {
+		void *resultado;
+		pthread_join(ids[h], &resultado);
+		error |= resultado != NULL;
+	}
+	pthread_mutex_destroy(&e->candado);
+	free(ids);
+
+	for (long t = 0; t < pasos; t++)
+		e->msd[t] = e->vivos[t] > 0 ? e->msd[t] / e->vivos[t] : 0;
+	e->sobrevivientes = ensamble_compactar(e->distancias, caminantes);
+	e->absorbidos = ensamble_compactar(e->tiempos, caminantes);
+	return error ? -1 : 0;
+}
+
+/*
+ * En dos dimensiones MSD(t) = 4 D t. D sale del ajuste por minimos cuadrados
+ * de una recta por el origen: D = sum t MSD(t) / (4 sum t^2).
+ */
+double ensamble_difusion(const Ensamble *e){
+	long double arriba = 0, abajo = 0;
+	for (long t = 1; t <= e->pasos; t++) {
+		arriba += (long double)t * e->msd[t - 1];
+		abajo += (long double)t * t;
+	}
+	return (double)(arriba / (4 * abajo));
+}
+
+#endif
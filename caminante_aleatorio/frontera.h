@@ -0,0 +1,161 @@
+#ifndef FRONTERA_H
+#define FRONTERA_H
+
+/*
+ * Condiciones de frontera en la caja [x0, x1] x [y0, y1].
+ *
+ *   libre        sin paredes.
+ *   reflejante   las paredes son espejos; un paso largo puede rebotar varias
+ *                veces, asi que la posicion se pliega con periodo 2 ancho.
+ *   periodica    lo que sale por un lado entra por el opuesto.
+ *   absorbente   el caminante que toca una pared se retira; el paso en que
+ *                la toca es su tiempo de primer paso.
+ *
+ * Los retirados se quitan del grupo cambiandolos por el ultimo activo, de modo
+ * que los sobrevivientes siempre son los primeros del grupo y los nucleos de
+ * pasos.h solo recorren los bloques que aun tienen alguno.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "pasos.h"
+
+enum { LIBRE, REFLEJANTE, PERIODICA, ABSORBENTE, FRONTERAS };
+
+static const char *const NOMBRES_FRONTERAS[FRONTERAS] = {
+	"libre", "reflejante", "periodica", "absorbente",
+};
+
+typedef struct {
+	int tipo;
+	double x0, x1, y0, y1;
+} Frontera;
+
+// Frontera por nombre, o -1 si no existe.
+int frontera_tipo(const char *nombre){
+	for (int k = 0; k < FRONTERAS; k++)
+		if (strcmp(nombre, NOMBRES_FRONTERAS[k]) == 0)
+			return k;
+	return -1;
+}
+
+// Devuelve -1 si la caja esta vacia.
+int frontera_iniciar(Frontera *f, int tipo, double x0, double x1, double y0, double y1){
+	if (tipo < 0 || tipo >= FRONTERAS || !(x1 > x0) || !(y1 > y0))
+		return -1;
+	f->tipo = tipo;
+	f->x0 = x0;
+	f->x1 = x1;
+	f->y0 = y0;
+	f->y1 = y1;
+	return 0;
+}
+
+/*
+ * floor(v) para |v| < 2^51, como v - 1/2 redondeado con el numero magico. Sin
+ * -fno-trapping-math el vectorizador no convierte floor() ni las comparaciones
+ * entre dobles en AVX2, asi que todo va con sumas y fabs. Si v es entero puede
+ * dar v - 1; en los dos pliegues eso deja el punto en la pared de enfrente, que
+ * es el mismo.
+ */
+static inline double frontera_piso(double v){
+	return (v - 0.5 + 0x1.8p52) - 0x1.8p52;
+}
+
+static inline double frontera_periodica(double v, double minimo, double ancho){
+	double u = v - minimo;
+	return minimo + (u - ancho * frontera_piso(u / ancho));
+}
+
+static inline double frontera_reflejante(double v, double minimo, double ancho){
+	double u = v - minimo;
+	u -= 2 * ancho * frontera_piso(u / (2 * ancho));
+	return minimo + ancho - fabs(u - ancho);
+}
+
+static inline int frontera_fuera(const Frontera *f, double x, double y){
+	return (x < f->x0) | (x > f->x1) | (y < f->y0) | (y > f->y1);
+}
+
+/*
+ * Un solo punto, para la ventana. Devuelve 1 si quedo absorbido; con la
+ * frontera periodica, 1 si dio la vuelta (para no unir los dos lados).
+ */
+int frontera_punto(const Frontera *f, double *x, double *y){
+	double ancho = f->x1 - f->x0, alto = f->y1 - f->y0;
+	switch (f->tipo) {
+	case REFLEJANTE:
+		*x = frontera_reflejante(*x, f->x0, ancho);
+		*y = frontera_reflejante(*y, f->y0, alto);
+		return 0;
+	case PERIODICA:
+		if (!frontera_fuera(f, *x, *y))
+			return 0;
+		*x = frontera_periodica(*x, f->x0, ancho);
+		*y = frontera_periodica(*y, f->y0, alto);
+		return 1;
+	case ABSORBENTE:
+		return frontera_fuera(f, *x, *y);
+	}
+	return 0;
+}
+
+/*
+ * Aplica la frontera a los primeros 'activos' caminantes del grupo. Con la
+ * absorbente, marca en fuera[] a los que salieron y devuelve si hubo alguno.
+ */
+__attribute__((target_clones("avx512f", "avx2", "default")))
+int frontera_grupo(const Frontera *f, Grupo *g, int activos, int64_t *restrict fuera){
+	const double x0 = f->x0, x1 = f->x1, y0 = f->y0, y1 = f->y1;
+	const double ancho = x1 - x0, alto = y1 - y0;
+	const int tipo = f->tipo, bloques = (activos + BLOQUE_GRUPO - 1) / BLOQUE_GRUPO;
+	int64_t alguno = 0;
+
+	for (int base = 0; base < bloques * BLOQUE_GRUPO; base += BLOQUE_GRUPO) {
+		double *restrict x = g->x + base, *restrict y = g->y + base;
+		switch (tipo) {
+		case REFLEJANTE:
+			for (int i = 0; i < BLOQUE_GRUPO; i++) {
+				x[i] = frontera_reflejante(x[i], x0, ancho);
+				y[i] = frontera_reflejante(y[i], y0, alto);
+			}
+			break;
+		case PERIODICA:
+			for (int i = 0; i < BLOQUE_GRUPO; i++) {
+				x[i] = frontera_periodica(x[i], x0, ancho);
+				y[i] = frontera_periodica(y[i], y0, alto);
+			}
+			break;
+		case ABSORBENTE:
+			for (int i = 0; i < BLOQUE_GRUPO; i++) {
+				fuera[base + i] = (x[i] < x0) | (x[i] > x1) | (y[i] < y0) | (y[i] > y1);
+				alguno |= fuera[base + i];
+			}
+			break;
+		}
+	}
+	return alguno != 0;
+}
+
+/*
+ * Retira a los marcados en fuera[] entre los primeros *activos: cada uno se
+ * reemplaza por el ultimo activo (que tambien se revisa) y *activos baja.
+ * Devuelve cuantos se retiraron.
+ */
+int frontera_retirar(Grupo *g, int *activos, int64_t *fuera){
+	int retirados = 0;
+	for (int i = 0; i < *activos; ) {
+		if (!fuera[i]) {
+			i++;
+			continue;
+		}
+		int ultimo = --*activos;
+		grupo_copiar(g, i, ultimo);
+		fuera[i] = fuera[ultimo];
+		retirados++;
+	}
+	return retirados;
+}
+
+#endif
@@ -0,0 +1,422 @@
+#ifndef PASOS_H
+#define PASOS_H
+
+/*
+ * Distribuciones del paso del caminante y los nucleos que las aplican a un
+ * grupo de caminantes guardado como estructura de arreglos.
+ *
+ *   red4, red8   un paso de largo L a uno de los 4 u 8 vecinos de la red.
+ *   angulo       largo L en una de DIRECCIONES direcciones (la de la ventana).
+ *   gauss        desplazamiento normal en cada eje con E[r^2] = L^2 (zigurat).
+ *   levy         vuelo de Levy: direccion uniforme y largo L u^(-1/alfa),
+ *                con cola de Pareto.
+ *
+ * Ninguna llama a cos, sin, exp, log ni pow dentro del ciclo: todo sale de
+ * tablas que se llenan una vez. Cada distribucion tiene una parte rapida sin
+ * saltos, que es la que se vectoriza, y una lenta para los casos raros que la
+ * rapida no resuelve (el rechazo de Lemire, la cola y las cunas del zigurat);
+ * la lenta corre despues, solo en los carriles que la necesitan.
+ *
+ * DEFINIR_PASO genera el nucleo de cada distribucion con sus funciones fijas,
+ * asi que dentro del ciclo no se pregunta de que distribucion se trata; el
+ * nucleo se escoge una vez al iniciar.
+ *
+ * Para el vuelo de Levy el largo usa los 64 bits: el exponente de u indexa
+ * una tabla de potencias y la mantisa se interpola en otra, asi que la cola
+ * llega hasta u = 2^-64 sin perder precision relativa.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "../comun/aleatorio.h"
+
+#define GRUPO_CAMINANTES 1024
+#define BLOQUE_GRUPO 64
+#define DIRECCIONES 360
+#define GIROS 4096
+#define BITS_MANTISA 11
+#define PASO 40.0
+
+enum { RED4, RED8, ANGULO, GAUSS, LEVY, DISTRIBUCIONES };
+
+static const char *const NOMBRES_DISTRIBUCIONES[DISTRIBUCIONES] = {
+	"red4", "red8", "angulo", "gauss", "levy",
+};
+
+typedef struct {
+	_Alignas(64) double x[GRUPO_CAMINANTES];
+	_Alignas(64) double y[GRUPO_CAMINANTES];
+	_Alignas(64) uint64_t s0[GRUPO_CAMINANTES];
+	_Alignas(64) uint64_t s1[GRUPO_CAMINANTES];
+	_Alignas(64) uint64_t s2[GRUPO_CAMINANTES];
+	_Alignas(64) uint64_t s3[GRUPO_CAMINANTES];
+} Grupo;
+
+typedef struct Pasos Pasos;
+typedef void (*PasoGrupo)(const Pasos *, Grupo *, int);
+typedef void (*PasoUno)(const Pasos *, Grupo *, int, double *, double *);
+
+struct Pasos {
+	int tipo;
+	double largo, alfa;
+	double sigma;                                 // desviacion por eje de gauss
+	double red_x[8], red_y[8];
+	double coseno[DIRECCIONES], seno[DIRECCIONES];
+	double giro_x[GIROS], giro_y[GIROS];          // direcciones del vuelo de Levy
+	int64_t zk[128];                              // zigurat: limites
+	double zw[128], zf[128];                      // anchos y alturas
+	double potencia[65];                          // L 2^(k / alfa)
+	double mantisa[(1 << BITS_MANTISA) + 1];      // (1 + j / 2^BITS)^(-1 / alfa)
+	PasoGrupo grupo;
+	PasoUno uno;
+};
+
+void grupo_iniciar(Grupo *g, unsigned long long semilla, uint64_t flujo){
+	Generador generador;
+	generador_iniciar(&generador, semilla, flujo);
+	for (int i = 0; i < GRUPO_CAMINANTES; i++) {
+		uint64_t mezcla = generador_u64(&generador);
+		g->s0[i] = splitmix64(&mezcla);
+		g->s1[i] = splitmix64(&mezcla);
+		g->s2[i] = splitmix64(&mezcla);
+		g->s3[i] = splitmix64(&mezcla);
+		g->x[i] = g->y[i] = 0;
+	}
+}
+
+// xoshiro256** del caminante i.
+static inline uint64_t grupo_aleatorio(Grupo *g, int i){
+	uint64_t t = g->s1[i] * 5;
+	uint64_t r = ((t << 7) | (t >> 57)) * 9;
+	t = g->s1[i] << 17;
+	g->s2[i] ^= g->s0[i];
+	g->s3[i] ^= g->s1[i];
+	g->s1[i] ^= g->s2[i];
+	g->s0[i] ^= g->s3[i];
+	g->s2[i] ^= t;
+	g->s3[i] = (g->s3[i] << 45) | (g->s3[i] >> 19);
+	return r;
+}
+
+// Uniforme en (0, 1), para los caminos lentos que usan logaritmos.
+static inline double grupo_uniforme(Grupo *g, int i){
+	return ((grupo_aleatorio(g, i) >> 11) + 0.5) * 0x1.0p-53;
+}
+
+/*
+ * Lo mismo para los primeros 'bloques' bloques de BLOQUE_GRUPO caminantes.
+ * Las multiplicaciones por 5 y por 9 van como corrimientos y sumas porque no
+ * hay multiplicacion vectorial de 64 bits antes de AVX-512.
+ */
+static inline void grupo_aleatorios(Grupo *g, uint64_t *restrict r, int bloques){
+	for (int base = 0; base < bloques * BLOQUE_GRUPO; base += BLOQUE_GRUPO) {
+		uint64_t *restrict s0 = g->s0 + base, *restrict s1 = g->s1 + base;
+		uint64_t *restrict s2 = g->s2 + base, *restrict s3 = g->s3 + base;
+		uint64_t *restrict rb = r + base;
+		for (int i = 0; i < BLOQUE_GRUPO; i++) {
+			uint64_t t = (s1[i] << 2) + s1[i];
+			t = (t << 7) | (t >> 57);
+			rb[i] = (t << 3) + t;
+			t = s1[i] << 17;
+			s2[i] ^= s0[i];
+			s3[i] ^= s1[i];
+			s1[i] ^= s2[i];
+			s0[i] ^= s3[i];
+			s2[i] ^= t;
+			s3[i] = (s3[i] << 45) | (s3[i] >> 19);
+		}
+	}
+}
+
+// Copia el caminante 'origen' del grupo sobre 'destino', con su generador.
+static inline void grupo_copiar(Grupo *g, int destino, int origen){
+	g->x[destino] = g->x[origen];
+	g->y[destino] = g->y[origen];
+	g->s0[destino] = g->s0[origen];
+	g->s1[destino] = g->s1[origen];
+	g->s2[destino] = g->s2[origen];
+	g->s3[destino] = g->s3[origen];
+}
+
+/*
+ * Partes rapidas: con los bits a y b dejan el desplazamiento en dx, dy y
+ * devuelven las partes que faltan (0 si ninguna). Partes lentas: terminan lo
+ * que falte con mas aleatorios del caminante i.
+ *
+ * Las rapidas trabajan todo en 64 bits, igual que los aleatorios y los
+ * dobles, porque el vectorizador no mezcla carriles de anchos distintos.
+ * Por lo mismo los enteros pasan a doble con el truco del numero magico y no
+ * con una conversion, que en AVX2 no existe para 64 bits.
+ */
+static inline int64_t red4_rapido(const Pasos *p, uint64_t a, uint64_t b, double *dx, double *dy){
+	(void)b;
+	*dx = p->red_x[a >> 62];
+	*dy = p->red_y[a >> 62];
+	return 0;
+}
+
+static inline int64_t red8_rapido(const Pasos *p, uint64_t a, uint64_t b, double *dx, double *dy){
+	(void)b;
+	*dx = p->red_x[a >> 61];
+	*dy = p->red_y[a >> 61];
+	return 0;
+}
+
+static inline void sin_lento(const Pasos *p, Grupo *g, int i, uint64_t a, uint64_t b, int falta,
+                             double *dx, double *dy){
+	(void)p; (void)g; (void)i; (void)a; (void)b; (void)falta; (void)dx; (void)dy;
+}
+
+// v exacto para |v| < 2^51.
+static inline double entero_doble(int64_t v){
+	uint64_t bits = 0x4338000000000000ULL + (uint64_t)v;
+	double d;
+	memcpy(&d, &bits, sizeof(d));
+	return d - 0x1.8p52;
+}
+
+// Doble con los bits dados.
+static inline double bits_doble(uint64_t bits){
+	double d;
+	memcpy(&d, &bits, sizeof(d));
+	return d;
+}
+
+static inline uint64_t doble_bits(double d){
+	uint64_t bits;
+	memcpy(&bits, &d, sizeof(bits));
+	return bits;
+}
+
+// 2^32 mod DIRECCIONES: debajo de eso la multiplicacion de Lemire esta sesgada.
+#define UMBRAL_DIRECCIONES ((uint32_t)(-(uint32_t)DIRECCIONES) % DIRECCIONES)
+
+static inline int64_t angulo_rapido(const Pasos *p, uint64_t a, uint64_t b, double *dx, double *dy){
+	(void)b;
+	uint64_t m = (a >> 32) * DIRECCIONES;
+	*dx = p->coseno[m >> 32];
+	*dy = p->seno[m >> 32];
+	return (m & 0xffffffff) < UMBRAL_DIRECCIONES;
+}
+
+static inline void angulo_lento(const Pasos *p, Grupo *g, int i, uint64_t a, uint64_t b, int falta,
+                                double *dx, double *dy){
+	(void)a; (void)b; (void)falta;
+	uint64_t m;
+	do
+		m = (grupo_aleatorio(g, i) >> 32) * DIRECCIONES;
+	while ((uint32_t)m < UMBRAL_DIRECCIONES);
+	*dx = p->coseno[m >> 32];
+	*dy = p->seno[m >> 32];
+}
+
+/*
+ * Zigurat de Marsaglia y Tsang con 128 capas. De cada 32 bits, los 7 bajos
+ * escogen la capa y los 25 altos (con signo) la posicion dentro de ella; casi
+ * siempre cae en la parte rectangular y se acepta sin mas.
+ */
+#define ZIGURAT_R 3.442619855899
+
+/*
+ * hz son los 25 bits altos (con signo) de una mitad de 32 bits e iz sus 7
+ * bits bajos.
+ */
+static inline int64_t gauss_eje(const Pasos *p, int64_t hz, uint64_t iz, double *v){
+	*v = p->sigma * (entero_doble(hz) * p->zw[iz]);
+	return (hz < 0 ? -hz : hz) >= p->zk[iz];
+}
+
+static inline int64_t gauss_rapido(const Pasos *p, uint64_t a, uint64_t b, double *dx, double *dy){
+	(void)b;
+	return gauss_eje(p, (int64_t)a >> 39, (a >> 32) & 127, dx) |
+	       gauss_eje(p, (int64_t)(a << 32) >> 39, a & 127, dy) << 1;
+}
+
+static double gauss_corregir(const Pasos *p, Grupo *g, int i, uint32_t r){
+	const double sigma = p->sigma;
+	for (;;) {
+		int32_t hz = (int32_t)r >> 7;
+		int iz = r & 127;
+		double x = hz * p->zw[iz];
+		if ((hz < 0 ? -hz : hz) < p->zk[iz])
+			return sigma * x;
+		if (iz == 0) {
+			double y;
+			do {
+				x = -log(grupo_uniforme(g, i)) / ZIGURAT_R;
+				y = -log(grupo_uniforme(g, i));
+			} while (y + y < x * x);
+			return sigma * (hz > 0 ? ZIGURAT_R + x : -ZIGURAT_R - x);
+		}
+		if (p->zf[iz] + grupo_uniforme(g, i) * (p->zf[iz - 1] - p->zf[iz]) < exp(-0.5 * x * x))
+			return sigma * x;
+		r = (uint32_t)(grupo_aleatorio(g, i) >> 32);
+	}
+}
+
+static inline void gauss_lento(const Pasos *p, Grupo *g, int i, uint64_t a, uint64_t b, int falta,
+                               double *dx, double *dy){
+	(void)b;
+	if (falta & 1)
+		*dx = gauss_corregir(p, g, i, (uint32_t)(a >> 32));
+	if (falta & 2)
+		*dy = gauss_corregir(p, g, i, (uint32_t)a);
+}
+
+/*
+ * u = a 2^-64. Los 64 bits de a pasan a doble en dos mitades exactas y una
+ * sola suma, asi que u conserva 53 bits significativos por pequeno que sea.
+ * Con u = 2^(e - 64) (1 + f), u^(-1/alfa) = 2^((64 - e) / alfa) (1 + f)^(-1/alfa):
+ * una potencia tabulada por la mantisa interpolada en su tabla.
+ */
+static inline int64_t levy_rapido(const Pasos *p, uint64_t a, uint64_t b, double *dx, double *dy){
+	a |= 1;   // a = 0 tiene probabilidad 2^-64 y no tiene exponente
+	double alto = bits_doble(0x4330000000000000ULL | (a >> 32)) - 0x1.0p52;
+	double bajo = bits_doble(0x4330000000000000ULL | (a & 0xffffffff)) - 0x1.0p52;
+	uint64_t u = doble_bits(alto * 0x1.0p32 + bajo);
+	uint64_t e = (u >> 52) - 1023;
+	uint64_t j = (u >> (52 - BITS_MANTISA)) & ((1 << BITS_MANTISA) - 1);
+	double f = bits_doble(0x3ff0000000000000ULL | ((u << BITS_MANTISA) & 0xfffffffffffffULL)) - 1;
+	double m = p->mantisa[j] + (p->mantisa[j + 1] - p->mantisa[j]) * f;
+	double largo = p->potencia[64 - e] * m;
+	*dx = largo * p->giro_x[b >> (64 - 12)];
+	*dy = largo * p->giro_y[b >> (64 - 12)];
+	return 0;
+}
+
+/*
+ * El nucleo avanza a los primeros 'activos' caminantes, redondeados a bloques
+ * completos de BLOQUE_GRUPO: los ciclos internos tienen largo fijo y se
+ * vectorizan, y los caminantes de sobra al final del ultimo bloque dan pasos
+ * que nadie lee.
+ */
+#define DEFINIR_PASO(nombre, PALABRAS, RAPIDO, LENTO)                                           \
+__attribute__((target_clones("avx512f", "avx2", "default")))                                   \
+static void paso_grupo_##nombre(const Pasos *p, Grupo *g, int activos){                        \
+	uint64_t a[GRUPO_CAMINANTES], b[GRUPO_CAMINANTES];                                        \
+	double dx[GRUPO_CAMINANTES], dy[GRUPO_CAMINANTES];                                        \
+	int64_t falta[GRUPO_CAMINANTES], alguno = 0;                                              \
+	int bloques = (activos + BLOQUE_GRUPO - 1) / BLOQUE_GRUPO;                                \
+	const uint64_t *segunda = (PALABRAS) > 1 ? b : a;                                         \
+	grupo_aleatorios(g, a, bloques);                                                          \
+	if ((PALABRAS) > 1)                                                                       \
+		grupo_aleatorios(g, b, bloques);                                                      \
+	for (int base = 0; base < bloques * BLOQUE_GRUPO; base += BLOQUE_GRUPO)                   \
+		for (int i = base; i < base + BLOQUE_GRUPO; i++) {                                    \
+			falta[i] = RAPIDO(p, a[i], segunda[i], &dx[i], &dy[i]);                           \
+			alguno |= falta[i];                                                               \
+		}                                                                                     \
+	for (int i = 0; alguno && i < bloques * BLOQUE_GRUPO; i++)                                \
+		if (falta[i])                                                                         \
+			LENTO(p, g, i, a[i], segunda[i], (int)falta[i], &dx[i], &dy[i]);                  \
+	for (int base = 0; base < bloques * BLOQUE_GRUPO; base += BLOQUE_GRUPO) {                 \
+		double *restrict x = g->x + base, *restrict y = g->y + base;                          \
+		for (int i = 0; i < BLOQUE_GRUPO; i++) {                                              \
+			x[i] += dx[base + i];                                                             \
+			y[i] += dy[base + i];                                                             \
+		}                                                                                     \
+	}                                                                                         \
+}                                                                                             \
+static void paso_uno_##nombre(const Pasos *p, Grupo *g, int i, double *dx, double *dy){       \
+	uint64_t a = grupo_aleatorio(g, i), b = (PALABRAS) > 1 ? grupo_aleatorio(g, i) : 0;      \
+	int falta = (int)RAPIDO(p, a, b, dx, dy);                                                 \
+	if (falta)                                                                                \
+		LENTO(p, g, i, a, b, falta, dx, dy);                                                  \
+}
+
+DEFINIR_PASO(red4, 1, red4_rapido, sin_lento)
+DEFINIR_PASO(red8, 1, red8_rapido, sin_lento)
+DEFINIR_PASO(angulo, 1, angulo_rapido, angulo_lento)
+DEFINIR_PASO(gauss, 1, gauss_rapido, gauss_lento)
+DEFINIR_PASO(levy, 2, levy_rapido, sin_lento)
+
+// Distribucion por nombre, o -1 si no existe.
+int pasos_distribucion(const char *nombre){
+	for (int k = 0; k < DISTRIBUCIONES; k++)
+		if (strcmp(nombre, NOMBRES_DISTRIBUCIONES[k]) == 0)
+			return k;
+	return -1;
+}
+
+static void pasos_zigurat(Pasos *p){
+	const double m = 16777216.0;   // 2^24, el mayor |hz|
+	double dn = ZIGURAT_R, tn = dn, vn = 9.91256303526217e-3;
+	double q = vn / exp(-0.5 * dn * dn);
+
+	p->zk[0] = (int64_t)(dn / q * m);
+	p->zk[1] = 0;
+	p->zw[0] = q / m;
+	p->zw[127] = dn / m;
+	p->zf[0] = 1.0;
+	p->zf[127] = exp(-0.5 * dn * dn);
+	for (int i = 126; i >= 1; i--) {
+		dn = sqrt(-2.0 * log(vn / dn + exp(-0.5 * dn * dn)));
+		p->zk[i + 1] = (int64_t)(dn / tn * m);
+		tn = dn;
+		p->zf[i] = exp(-0.5 * dn * dn);
+		p->zw[i] = dn / m;
+	}
+}
+
+/*
+ * Llena las tablas de la distribucion 'tipo' con pasos de largo 'largo'
+ * ('alfa' solo importa para Levy, en (0, 2]). Devuelve -1 si algo no es valido.
+ */
+int pasos_iniciar(Pasos *p, int tipo, double largo, double alfa){
+	static const PasoGrupo GRUPO[DISTRIBUCIONES] = {
+		paso_grupo_red4, paso_grupo_red8, paso_grupo_angulo, paso_grupo_gauss, paso_grupo_levy,
+	};
+	static const PasoUno UNO[DISTRIBUCIONES] = {
+		paso_uno_red4, paso_uno_red8, paso_uno_angulo, paso_uno_gauss, paso_uno_levy,
+	};
+	if (tipo < 0 || tipo >= DISTRIBUCIONES || !(largo > 0) || !(alfa > 0 && alfa <= 2))
+		return -1;
+
+	p->tipo = tipo;
+	p->largo = largo;
+	p->alfa = alfa;
+	p->sigma = largo / sqrt(2.0);
+	p->grupo = GRUPO[tipo];
+	p->uno = UNO[tipo];
+
+	// Vecinos en orden: este, norte, oeste, sur y luego las diagonales; las
+	// diagonales tambien miden L para que todos los pasos sean iguales
+	int vecinos = tipo == RED4 ? 4 : 8;
+	for (int k = 0; k < 8; k++) {
+		double angulo = vecinos == 4 ? M_PI / 2 * (k % 4) : M_PI / 4 * k;
+		p->red_x[k] = largo * cos(angulo);
+		p->red_y[k] = largo * sin(angulo);
+	}
+	for (int k = 0; k < DIRECCIONES; k++) {
+		p->coseno[k] = largo * cos(2 * M_PI * k / DIRECCIONES);
+		p->seno[k] = largo * sin(2 * M_PI * k / DIRECCIONES);
+	}
+	for (int k = 0; k < GIROS; k++) {
+		p->giro_x[k] = cos(2 * M_PI * (k + 0.5) / GIROS);
+		p->giro_y[k] = sin(2 * M_PI * (k + 0.5) / GIROS);
+	}
+	pasos_zigurat(p);
+	for (int k = 0; k <= 64; k++)
+		p->potencia[k] = largo * exp2(k / alfa);
+	for (int j = 0; j <= 1 << BITS_MANTISA; j++)
+		p->mantisa[j] = pow(1.0 + (double)j / (1 << BITS_MANTISA), -1.0 / alfa);
+	return 0;
+}
+
+// Suma de r^2 de los primeros n caminantes, en 8 sumas parciales.
+__attribute__((target_clones("avx512f", "avx2", "default")))
+double grupo_r2(const Grupo *g, int n){
+	double parcial[8] = {0};
+	int i = 0;
+	for (; i + 8 <= n; i += 8)
+		for (int j = 0; j < 8; j++)
+			parcial[j] += g->x[i + j] * g->x[i + j] + g->y[i + j] * g->y[i + j];
+	for (; i < n; i++)
+		parcial[0] += g->x[i] * g->x[i] + g->y[i] * g->y[i];
+	return ((parcial[0] + parcial[1]) + (parcial[2] + parcial[3])) +
+	       ((parcial[4] + parcial[5]) + (parcial[6] + parcial[7]));
+}
+
+#endif
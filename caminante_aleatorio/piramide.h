@@ -0,0 +1,227 @@
+#ifndef PIRAMIDE_H
+#define PIRAMIDE_H
+
+/*
+ * Piramide de resoluciones para dibujar trayectorias muy largas.
+ *
+ * El nivel 0 son los puntos del camino; el segmento j va del punto j al
+ * j + 1. En el nivel k cada nodo guarda la caja (x e y minimos y maximos) de
+ * RAMAS^k segmentos seguidos, es decir, de sus RAMAS hijos del nivel k - 1.
+ * Cada punto nuevo agranda un nodo por nivel, asi que la piramide se arma
+ * conforme llegan los pasos.
+ *
+ * Para dibujar se baja desde la cima: un nodo cuya caja no toca la vista se
+ * salta completo (y la linea se corta), y uno cuya caja mide menos de un pixel
+ * se dibuja como un solo segmento de su primer a su ultimo punto. Ademas no se
+ * repiten puntos que caen en el mismo pixel que el anterior. El numero de
+ * vertices depende entonces de cuantos pixeles cubre el camino en pantalla y
+ * no de su largo.
+ *
+ * Eso no basta si los pasos miden varios pixeles y el camino llena la
+ * pantalla (con una frontera reflejante, por ejemplo), asi que el trazo tiene
+ * un presupuesto de vertices: si no cabe, la tolerancia de un pixel se dobla
+ * y se vuelve a trazar desde un nivel mas arriba.
+ *
+ * Un punto NAN corta la linea (lo usa la frontera periodica).
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#define RAMAS 4
+#define BITS_RAMAS 2
+#define NIVELES_PIRAMIDE 16     // 4^15 segmentos en la cima: mas de 10^9
+
+typedef struct {
+	float x0, x1, y0, y1;
+} Caja;
+
+typedef struct {
+	float *x, *y;
+	size_t n, capacidad;
+	Caja *cajas[NIVELES_PIRAMIDE];          // el nivel 0 no se guarda
+	size_t capacidades[NIVELES_PIRAMIDE];
+} Piramide;
+
+// Mundo a pantalla: (punto - centro) * zoom + mitad de la pantalla.
+typedef struct {
+	double cx, cy, zoom;
+	int ancho, alto;
+} Vista;
+
+// Puntos ya en pantalla; NAN marca un corte de la linea.
+typedef struct {
+	float *x, *y;
+	size_t n, capacidad;
+	long ultimo;                            // ultimo punto del camino agregado
+	size_t presupuesto;                     // maximo de puntos; 0 es sin limite
+	double tolerancia;                      // tamano en pixeles de un nodo que se colapsa
+	double x0, x1, y0, y1;                  // la vista en el mundo
+	const Vista *vista;
+} Trazo;
+
+void piramide_liberar(Piramide *p){
+	free(p->x);
+	free(p->y);
+	for (int k = 1; k < NIVELES_PIRAMIDE; k++)
+		free(p->cajas[k]);
+}
+
+static int crecer(void **arreglo, size_t *capacidad, size_t necesaria, size_t tamano){
+	if (necesaria <= *capacidad)
+		return 0;
+	size_t nueva = *capacidad ? *capacidad : 1024;
+	while (nueva < necesaria)
+		nueva *= 2;
+	void *otro = realloc(*arreglo, nueva * tamano);
+	if (otro == NULL)
+		return -1;
+	*arreglo = otro;
+	*capacidad = nueva;
+	return 0;
+}
+
+// Lo mismo para dos arreglos de floats que comparten capacidad.
+static int crecer_par(float **x, float **y, size_t *capacidad, size_t necesaria){
+	size_t cx = *capacidad, cy = *capacidad;
+	if (crecer((void **)x, &cx, necesaria, sizeof(float)) != 0 ||
+	    crecer((void **)y, &cy, necesaria, sizeof(float)) != 0)
+		return -1;
+	*capacidad = cx;
+	return 0;
+}
+
+// Agrega un punto al final del camino. Devuelve -1 si falta memoria.
+int piramide_agregar(Piramide *p, float x, float y){
+	if (crecer_par(&p->x, &p->y, &p->capacidad, p->n + 1) != 0)
+		return -1;
+	p->x[p->n] = x;
+	p->y[p->n] = y;
+	if (p->n++ == 0)
+		return 0;
+
+	// El segmento nuevo s entra en el nodo s >> (2 k) de cada nivel k
+	size_t s = p->n - 2;
+	float x0 = fminf(p->x[s], x), x1 = fmaxf(p->x[s], x);
+	float y0 = fminf(p->y[s], y), y1 = fmaxf(p->y[s], y);
+	for (int k = 1; k < NIVELES_PIRAMIDE; k++) {
+		size_t j = s >> (BITS_RAMAS * k);
+		if (crecer((void **)&p->cajas[k], &p->capacidades[k], j + 1, sizeof(Caja)) != 0)
+			return -1;
+		Caja *c = &p->cajas[k][j];
+		if ((s & (((size_t)1 << (BITS_RAMAS * k)) - 1)) == 0) {
+			*c = (Caja){x0, x1, y0, y1};
+		} else {
+			c->x0 = fminf(c->x0, x0);
+			c->x1 = fmaxf(c->x1, x1);
+			c->y0 = fminf(c->y0, y0);
+			c->y1 = fmaxf(c->y1, y1);
+		}
+	}
+	return 0;
+}
+
+static void trazo_cortar(Trazo *t){
+	t->ultimo = -1;
+	if (t->n > 0 && !isnan(t->x[t->n - 1]) && crecer_par(&t->x, &t->y, &t->capacidad, t->n + 1) == 0) {
+		t->x[t->n] = t->y[t->n] = NAN;
+		t->n++;
+	}
+}
+
+static void trazo_punto(Trazo *t, const Piramide *p, size_t i){
+	const Vista *v = t->vista;
+	if (isnan(p->x[i])) {
+		trazo_cortar(t);
+		return;
+	}
+	float x = (float)((p->x[i] - v->cx) * v->zoom + v->ancho / 2.0);
+	float y = (float)((p->y[i] - v->cy) * v->zoom + v->alto / 2.0);
+	t->ultimo = (long)i;
+	if (t->n > 0 && floorf(t->x[t->n - 1]) == floorf(x) && floorf(t->y[t->n - 1]) == floorf(y))
+		return;
+	if (crecer_par(&t->x, &t->y, &t->capacidad, t->n + 1) != 0)
+		return;
+	t->x[t->n] = x;
+	t->y[t->n] = y;
+	t->n++;
+}
+
+static void trazo_segmento(Trazo *t, const Piramide *p, size_t a, size_t b){
+	if (t->ultimo != (long)a) {
+		trazo_cortar(t);
+		trazo_punto(t, p, a);
+	}
+	trazo_punto(t, p, b);
+}
+
+static void piramide_visitar(const Piramide *p, Trazo *t, int k, size_t j){
+	if (t->presupuesto > 0 && t->n > t->presupuesto)
+		return;
+	size_t primero = j << (BITS_RAMAS * k), ultimo = (j + 1) << (BITS_RAMAS * k);
+	if (ultimo > p->n - 1)
+		ultimo = p->n - 1;
+	Caja c;
+	if (k == 0)
+		c = (Caja){fminf(p->x[j], p->x[j + 1]), fmaxf(p->x[j], p->x[j + 1]),
+		           fminf(p->y[j], p->y[j + 1]), fmaxf(p->y[j], p->y[j + 1])};
+	else
+		c = p->cajas[k][j];
+
+	if (c.x1 < t->x0 || c.x0 > t->x1 || c.y1 < t->y0 || c.y0 > t->y1) {
+		trazo_cortar(t);
+		return;
+	}
+	if (k == 0 || ((c.x1 - c.x0) * t->vista->zoom < t->tolerancia &&
+	                (c.y1 - c.y0) * t->vista->zoom < t->tolerancia)) {
+		trazo_segmento(t, p, primero, ultimo);
+		return;
+	}
+	for (size_t h = j << BITS_RAMAS; h < (j + 1) << BITS_RAMAS && (h << (BITS_RAMAS * (k - 1))) < p->n - 1; h++)
+		piramide_visitar(p, t, k - 1, h);
+}
+
+static void piramide_trazar_una(const Piramide *p, Trazo *t){
+	t->n = 0;
+	t->ultimo = -1;
+	if (p->n == 1)
+		trazo_punto(t, p, 0);
+	if (p->n < 2)
+		return;
+
+	// La cima es el nivel mas bajo con un solo nodo
+	int k = 0;
+	while (k < NIVELES_PIRAMIDE - 1 && ((p->n - 2) >> (BITS_RAMAS * k)) > 0)
+		k++;
+	for (size_t j = 0; j <= (p->n - 2) >> (BITS_RAMAS * k); j++)
+		piramide_visitar(p, t, k, j);
+}
+
+/*
+ * Deja en t los puntos en pantalla del camino visto por v, sin pasar de
+ * t->presupuesto. Solo crece los arreglos de t, que se pueden reusar entre
+ * cuadros. Se empieza con la mitad de la tolerancia del cuadro anterior para
+ * que vuelva a bajar cuando se acerca la vista; un intento que no cabe se
+ * abandona en cuanto se pasa del presupuesto.
+ */
+void piramide_trazar(const Piramide *p, const Vista *v, Trazo *t){
+	t->vista = v;
+	t->x0 = v->cx - v->ancho / 2.0 / v->zoom;
+	t->x1 = v->cx + v->ancho / 2.0 / v->zoom;
+	t->y0 = v->cy - v->alto / 2.0 / v->zoom;
+	t->y1 = v->cy + v->alto / 2.0 / v->zoom;
+	t->tolerancia = t->tolerancia > 2 ? t->tolerancia / 2 : 1;
+	piramide_trazar_una(p, t);
+	while (t->presupuesto > 0 && t->n > t->presupuesto) {
+		t->tolerancia *= 2;
+		piramide_trazar_una(p, t);
+	}
+}
+
+void trazo_liberar(Trazo *t){
+	free(t->x);
+	free(t->y);
+}
+
+#endif
@@ -2,17 +2,371 @@
 #include <stdlib.h>
 #include <time.h>
 #include <math.h>
+#include <unistd.h>
 #include <CSFML/System.h>
 #include <CSFML/Graphics.h>
+#include "ensamble.h"
+#include "estimador.h"
+#include "trayectoria.h"
+#include "piramide.h"
+#include "../comun/grafica.h"
 
-const double Radian = 3.1416 / 180.0;
-const int Dice = 360;
 const int Step = 40;
 const int count =20000;
 
+// Densidad de Rayleigh: distancia final de un caminante tras muchos pasos.
+static double rayleigh(double r, const void *parametro) {
+	double sigma2 = *(const double *)parametro;
+	return r / sigma2 * exp(-r * r / (2 * sigma2));
+}
+
+/*
+ * Histograma de datos[0 .. n) en 'clases' clases desde 0 hasta el maximo, como
+ * CSV con Desde,Hasta,Frecuencia,Densidad y, si hay densidad, una columna mas
+ * con la teorica en el centro de cada clase.
+ */
+static int escribir_histograma(const char *nombre, const double *datos, long n, int clases,
+                               double (*densidad)(double, const void *), const void *parametro,
+                               const char *columna) {
+	double maximo = 0;
+	for (long i = 0; i < n; i++)
+		if (datos[i] > maximo)
+			maximo = datos[i];
+	long *cuentas = calloc(clases, sizeof(long));
+	FILE *f = fopen(nombre, "w");
+	if (cuentas == NULL || f == NULL) {
+		free(cuentas);
+		if (f != NULL)
+			fclose(f);
+		return -1;
+	}
+	double ancho = maximo > 0 ? maximo / clases : 1;
+	for (long i = 0; i < n; i++) {
+		int c = (int)(datos[i] / ancho);
+		cuentas[c < clases ? c : clases - 1]++;
+	}
+	fprintf(f, "Desde,Hasta,Frecuencia,Densidad%s%s\n", densidad != NULL ? "," : "",
+	        densidad != NULL ? columna : "");
+	for (int c = 0; c < clases; c++) {
+		fprintf(f, "%.4f,%.4f,%ld,%.8g", c * ancho, (c + 1) * ancho, cuentas[c],
+		        cuentas[c] / (n * ancho));
+		if (densidad != NULL)
+			fprintf(f, ",%.8g", densidad((c + 0.5) * ancho, parametro));
+		fprintf(f, "\n");
+	}
+	free(cuentas);
+	return fclose(f) == 0 ? 0 : -1;
+}
+
+/*
+ * Tiempo de primer paso: media y varianza de los absorbidos, y su histograma
+ * en primer_paso.csv y primer_paso.svg.
+ */
+static void escribir_primer_paso(const Ensamble *e, const Frontera *frontera, const Pasos *distribucion) {
+	printf("Absorbidos: %ld de %ld (%.2f%%)\n", e->absorbidos, e->caminantes,
+	       100.0 * e->absorbidos / e->caminantes);
+	if (e->absorbidos == 0)
+		return;
+
+	long double suma = 0, suma2 = 0;
+	for (long i = 0; i < e->absorbidos; i++) {
+		suma += e->tiempos[i];
+		suma2 += (long double)e->tiempos[i] * e->tiempos[i];
+	}
+	double media = (double)(suma / e->absorbidos);
+	double varianza = e->absorbidos > 1 ? (double)((suma2 - suma * suma / e->absorbidos) / (e->absorbidos - 1)) : 0;
+	printf("Tiempo de primer paso: media %.4f pasos, varianza %.4f, error estandar %.4f\n",
+	       media, varianza, sqrt(varianza / e->absorbidos));
+
+	// Salida de un cuadrado de lado 2h desde el centro con difusion D = L^2 / 4:
+	// E[T] = 0.29468 h^2 / D. Solo se compara si todos salieron, y el caminante
+	// discreto tarda un poco mas porque solo se revisa al final de cada paso
+	double h = (frontera->x1 - frontera->x0) / 2;
+	if (distribucion->tipo != LEVY && e->absorbidos == e->caminantes)
+		printf("Para un movimiento browniano: %.4f pasos\n", 0.29468 * h * h / (PASO * PASO / 4));
+
+	if (escribir_histograma("primer_paso.csv", e->tiempos, e->absorbidos, 100, NULL, NULL, NULL) != 0)
+		printf("Error: no se pudo escribir primer_paso.csv.\n");
+	if (grafica_histograma("primer_paso.svg", "Tiempo de primer paso a la frontera", "Pasos",
+	                       "Densidad", e->tiempos, e->absorbidos, 100, NULL, NULL, NULL) != 0)
+		printf("Error: no se pudo escribir primer_paso.svg.\n");
+}
+
+/*
+ * Modo sin ventana: simula el ensamble y escribe msd.csv, distancia.csv y
+ * distancia.svg (y primer_paso.csv y primer_paso.svg con la frontera
+ * absorbente). Para el vuelo de Levy la distancia no tiene varianza finita,
+ * asi que el histograma es de log10 de la distancia y sin la Rayleigh; la
+ * Rayleigh tampoco vale con paredes.
+ */
+int correr_ensamble(const Pasos *distribucion, const Frontera *frontera, long caminantes, long pasos,
+                    int hilos, unsigned long long semilla) {
+	Ensamble e;
+	struct timespec inicio, fin;
+	int levy = distribucion->tipo == LEVY, libre = frontera->tipo == LIBRE;
+
+	clock_gettime(CLOCK_MONOTONIC, &inicio);
+	if (ensamble_simular(&e, distribucion, frontera, caminantes, pasos, hilos, semilla) != 0) {
+		printf("Error: memoria insuficiente para el ensamble.\n");
+		return 1;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &fin);
+	double tiempo = (fin.tv_sec - inicio.tv_sec) + (fin.tv_nsec - inicio.tv_nsec) * 1e-9;
+
+	// Los absorbidos ya no dan pasos, asi que los pasos dados son los activos
+	double difusion = ensamble_difusion(&e), dados = 0;
+	for (long t = 0; t < pasos; t++)
+		dados += e.vivos[t];
+	printf("%ld caminantes x %ld pasos (%s, frontera %s) en %.2f s (%.2f M pasos/s) con %d hilos\n",
+	       caminantes, pasos, NOMBRES_DISTRIBUCIONES[distribucion->tipo],
+	       NOMBRES_FRONTERAS[frontera->tipo], tiempo, dados / tiempo / 1e6, hilos);
+	if (libre && levy)
+		printf("Coeficiente de difusion: D = %.4f unidades^2/paso (alfa = %g: sin valor finito)\n",
+		       difusion, distribucion->alfa);
+	else if (libre)
+		printf("Coeficiente de difusion: D = %.4f unidades^2/paso (teorico %.4f)\n",
+		       difusion, PASO * PASO / 4);
+
+	FILE *msd = fopen("msd.csv", "w");
+	if (msd == NULL) {
+		printf("Error: no se pudo escribir msd.csv.\n");
+		ensamble_liberar(&e);
+		return 1;
+	}
+	fprintf(msd, "Paso,MSD,Activos\n");
+	for (long t = 0; t < pasos; t++)
+		fprintf(msd, "%ld,%.6f,%ld\n", t + 1, e.msd[t], e.vivos[t]);
+	fclose(msd);
+
+	if (frontera->tipo == ABSORBENTE)
+		escribir_primer_paso(&e, frontera, distribucion);
+
+	// Histograma de la distancia final, con la Rayleigh de varianza N L^2 / 2 encima
+	const int clases = 100;
+	double sigma2 = pasos * PASO * PASO / 2;
+	double (*densidad)(double, const void *) = levy || !libre ? NULL : rayleigh;
+	if (levy)
+		for (long i = 0; i < e.sobrevivientes; i++)
+			e.distancias[i] = log10(e.distancias[i] > 1 ? e.distancias[i] : 1);
+	if (e.sobrevivientes > 0) {
+		if (escribir_histograma("distancia.csv", e.distancias, e.sobrevivientes, clases, densidad,
+		                        &sigma2, "Rayleigh") != 0)
+			printf("Error: no se pudo escribir distancia.csv.\n");
+
+		char leyenda[64];
+		snprintf(leyenda, sizeof(leyenda), "Rayleigh, sigma^2 = %g", sigma2);
+		if (grafica_histograma("distancia.svg", "Distancia del punto inicial al final",
+		                       levy ? "log10 Distancia" : "Distancia", "Densidad", e.distancias,
+		                       e.sobrevivientes, clases, densidad, &sigma2, leyenda) != 0)
+			printf("Error: no se pudo escribir distancia.svg.\n");
+	}
+
+	ensamble_liberar(&e);
+	return 0;
+}
+
+/*
+ * Modo estimador: distancia media tras 'pasos' pasos con la precision relativa
+ * pedida, simulando a lo mas 'caminantes'. Tambien dice cuantas muestras
+ * habria necesitado el promedio simple para el mismo intervalo.
+ */
+int correr_estimador(const Pasos *distribucion, const Frontera *frontera, long pasos, long caminantes,
+                     double precision, int hilos, unsigned long long semilla) {
+	Estimador e;
+	struct timespec inicio, fin;
+
+	if (frontera->tipo == ABSORBENTE) {
+		printf("Error: con la frontera absorbente no todos los caminantes tienen distancia final.\n");
+		return 1;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &inicio);
+	if (estimador_correr(&e, distribucion, frontera, pasos, caminantes, precision, hilos, semilla) != 0) {
+		printf("Error: memoria insuficiente para el estimador.\n");
+		return 1;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &fin);
+	double tiempo = (fin.tv_sec - inicio.tv_sec) + (fin.tv_nsec - inicio.tv_nsec) * 1e-9;
+	long n = (long)e.total.n;
+
+	printf("%ld caminantes x %ld pasos (%s, frontera %s) en %.2f s con %d hilos\n", n, pasos,
+	       NOMBRES_DISTRIBUCIONES[distribucion->tipo], NOMBRES_FRONTERAS[frontera->tipo], tiempo, hilos);
+	printf("Distancia media: %.4f +- %.4f unidades (95%%, %s)\n", e.media, e.error,
+	       e.control ? "con r^2 como variable de control" : "promedio simple");
+	if (e.control) {
+		double razon = e.error_simple * e.error_simple / (e.error * e.error);
+		printf("Promedio simple: %.4f +- %.4f; habria necesitado %.1f veces mas caminantes\n",
+		       e.simple, e.error_simple, razon);
+		// Rayleigh de varianza N L^2 / 2: media L sqrt(pi N) / 2
+		printf("Limite de muchos pasos: %.4f unidades\n", distribucion->largo * sqrt(M_PI * pasos) / 2);
+	}
+	if (distribucion->tipo == LEVY)
+		printf("Aviso: con el vuelo de Levy r no tiene varianza finita y el intervalo no es confiable.\n");
+	if (e.error > precision * fabs(e.media))
+		printf("Aviso: no se llego a la precision %g con %ld caminantes.\n", precision, caminantes);
+	return 0;
+}
+
+/*
+ * Graba sin ventana un caminante de 'pasos' pasos que empieza en el origen,
+ * dentro de 'frontera'. No guarda nada en memoria, asi que sirve para caminos
+ * de 10^9 pasos.
+ */
+int grabar_camino(const Pasos *distribucion, const Frontera *frontera, Grupo *grupo, long pasos,
+                  unsigned long long semilla, const char *nombre) {
+	Grabadora grabadora;
+	struct timespec inicio, fin;
+	double x = 0, y = 0, dx, dy;
+
+	// Los pasos gaussianos y de Levy casi nunca se repiten
+	int estrategia = distribucion->tipo == LEVY || distribucion->tipo == GAUSS ? Z_HUFFMAN_ONLY
+	                                                                           : Z_DEFAULT_STRATEGY;
+	if (grabadora_abrir(&grabadora, nombre, ESCALA_TRAYECTORIA, x, y, estrategia) != 0) {
+		printf("Error: no se pudo crear %s.\n", nombre);
+		return 1;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &inicio);
+	grupo_iniciar(grupo, semilla, 0);
+	int error = 0;
+	long t;
+	for (t = 0; t < pasos && !error; t++) {
+		distribucion->uno(distribucion, grupo, 0, &dx, &dy);
+		x += dx;
+		y += dy;
+		if (frontera_punto(frontera, &x, &y) && frontera->tipo == ABSORBENTE)
+			pasos = t + 1;
+		error = grabadora_paso(&grabadora, x, y);
+	}
+	error |= grabadora_cerrar(&grabadora);
+	clock_gettime(CLOCK_MONOTONIC, &fin);
+	if (error) {
+		printf("Error: no se pudo escribir %s.\n", nombre);
+		return 1;
+	}
+
+	struct stat datos;
+	double tiempo = (fin.tv_sec - inicio.tv_sec) + (fin.tv_nsec - inicio.tv_nsec) * 1e-9;
+	stat(nombre, &datos);
+	printf("%ld pasos grabados en %s en %.2f s (%.2f M pasos/s): %.0f bytes, %.3f bytes por paso\n",
+	       t, nombre, tiempo, t / tiempo / 1e6, (double)datos.st_size, (double)datos.st_size / t);
+	printf("Posicion final: (%.4f, %.4f)\n", x, y);
+	return 0;
+}
+
 int main(int argc, char **argv) {
+	long caminantes = 0, pasos = count;
+	int opcion, hilos = (int)sysconf(_SC_NPROCESSORS_ONLN), tipo = ANGULO, borde = -1;
+	unsigned long long semilla = (unsigned long long)time(NULL);
+	double alfa = 1.5, lado = 4000, precision = 0;
+	const char *grabar = NULL, *reproducir = NULL;
+	long desde = 0, por_cuadro = 1;
+
+	// Con -m se simulan m caminantes de -n pasos sin abrir la ventana,
+	// repartidos en -t hilos y con semilla -s. -d escoge la distribucion del
+	// paso (tambien en la ventana) y -a el exponente del vuelo de Levy. -f
+	// escoge la frontera: en la ventana son sus bordes (reflejante si no se
+	// dice otra cosa) y en el ensamble un cuadrado de lado -c centrado en el
+	// origen (libre si no se dice otra cosa).
+	//
+	// Con -e se estima la distancia media tras -n pasos hasta que la mitad del
+	// intervalo del 95% es la fraccion -e de ella, con a lo mas -m caminantes.
+	//
+	// Con -g se graba sin ventana un solo caminante de -n pasos en un archivo;
+	// con -r se abre la ventana y se reproduce uno grabado desde el paso -i.
+	// En la ventana -n es el numero de pasos (count si no se dice) y -v
+	// cuantos se dan en cada cuadro.
+	while ((opcion = getopt(argc, argv, "m:n:t:s:d:a:f:c:g:r:i:v:e:")) != -1) {
+		switch (opcion) {
+		case 'm': caminantes = atol(optarg); break;
+		case 'n': pasos = atol(optarg); break;
+		case 't': hilos = atoi(optarg); break;
+		case 's': semilla = strtoull(optarg, NULL, 10); break;
+		case 'a': alfa = atof(optarg); break;
+		case 'c': lado = atof(optarg); break;
+		case 'g': grabar = optarg; break;
+		case 'r': reproducir = optarg; break;
+		case 'i': desde = atol(optarg); break;
+		case 'v': por_cuadro = atol(optarg); break;
+		case 'e': precision = atof(optarg); break;
+		case 'f':
+			if ((borde = frontera_tipo(optarg)) < 0) {
+				printf("Error: frontera desconocida '%s'.\n", optarg);
+				return 1;
+			}
+			break;
+		case 'd':
+			if ((tipo = pasos_distribucion(optarg)) < 0) {
+				printf("Error: distribucion desconocida '%s'.\n", optarg);
+				return 1;
+			}
+			break;
+		default:
+			fprintf(stderr, "Uso: %s [-d red4|red8|angulo|gauss|levy] [-a alfa] "
+			                "[-f libre|reflejante|periodica|absorbente] "
+			                "[-m caminantes [-n pasos] [-t hilos] [-s semilla] [-c lado]] [-e precision] "
+			                "[-g archivo [-n pasos]] [-r archivo [-i paso]] [-n pasos] [-v pasos_por_cuadro]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	Pasos *distribucion = malloc(sizeof(Pasos));
+	Grupo *grupo = aligned_alloc(64, sizeof(Grupo));
+	if (distribucion == NULL || grupo == NULL) {
+		printf("Error: memoria insuficiente.\n");
+		return 1;
+	}
+	int ventana = caminantes <= 0 && grabar == NULL && precision <= 0;
+	if (pasos_iniciar(distribucion, tipo, ventana ? Step : PASO, alfa) != 0) {
+		printf("Error: alfa debe estar en (0, 2].\n");
+		return 1;
+	}
+	Frontera frontera;
+	if (!ventana) {
+		int resultado = 1;
+		if (precision > 0 && caminantes <= 0)
+			caminantes = 1L << 26;
+		if (pasos <= 0 || hilos <= 0 || caminantes < 0 ||
+		    frontera_iniciar(&frontera, borde < 0 ? LIBRE : borde, -lado / 2, lado / 2, -lado / 2, lado / 2) != 0)
+			printf("Error: numero de pasos, de hilos o lado de la caja invalido.\n");
+		else if (precision > 0)
+			resultado = correr_estimador(distribucion, &frontera, pasos, caminantes, precision, hilos, semilla);
+		else if (grabar != NULL)
+			resultado = grabar_camino(distribucion, &frontera, grupo, pasos, semilla, grabar);
+		else
+			resultado = correr_ensamble(distribucion, &frontera, caminantes, pasos, hilos, semilla);
+		free(distribucion);
+		free(grupo);
+		return resultado;
+	}
+	frontera_iniciar(&frontera, borde < 0 ? REFLEJANTE : borde, 0, 1365, 0, 701);
+	if (pasos <= 0 || por_cuadro <= 0) {
+		printf("Error: numero de pasos o de pasos por cuadro invalido.\n");
+		return 1;
+	}
+
+	// Al reproducir se leen por_cuadro pasos en cada cuadro, movidos para que
+	// el primero quede en el centro de la ventana
+	Reproductor reproductor;
+	double *grabado_x = NULL, *grabado_y = NULL, origen_x = 0, origen_y = 0;
+	if (reproducir != NULL) {
+		grabado_x = malloc((por_cuadro + 1) * sizeof(double));
+		grabado_y = malloc((por_cuadro + 1) * sizeof(double));
+		if (grabado_x == NULL || grabado_y == NULL || desde < 0 ||
+		    reproductor_abrir(&reproductor, reproducir) != 0) {
+			printf("Error: no se pudo abrir la trayectoria %s.\n", reproducir);
+			return 1;
+		}
+		if (reproductor_leer(&reproductor, desde, 1, grabado_x, grabado_y) != 1) {
+			printf("Error: la trayectoria no llega al paso %ld o esta danada.\n", desde);
+			return 1;
+		}
+		origen_x = 683 - grabado_x[0];
+		origen_y = 351 - grabado_y[0];
+		printf("Trayectoria de %llu pasos; se reproducen desde el paso %ld\n",
+		       (unsigned long long)reproductor.pasos, desde);
+	}
 
 	srand(time(NULL));
+	grupo_iniciar(grupo, semilla, 0);
 	
 	sfVideoMode mode = {1366, 768, 32};
 	sfRenderWindow *window = 
@@ -21,20 +375,36 @@ int main(int argc, char **argv) {
 										sfResize | sfClose, 
 										sfWindowed, NULL);
 	
-	int flag = 0, iteration = 0, x = (rand() % 1366) + 1, y = (rand() % 701) + 1;
+	int flag = 0;
+	long iteration = 0;
+	double x = (rand() % 1366) + 1, y = (rand() % 701) + 1, dx, dy;
+	if (reproducir != NULL) {
+		x = grabado_x[0] + origen_x;
+		y = grabado_y[0] + origen_y;
+	}
 	sfTime T;
 	T.microseconds = 100000;
 	sfVector2f v = { x, y};
-	sfVertex tmp, start, end;
+	sfVertex tmp, start, end, corte;
 	
-	tmp.position = v;
+	corte.color = sfTransparent;
 	tmp.color = sfGreen;
 	start.color = sfRed;
 	end.color = sfRed;
+
+	// El camino completo vive en la piramide (piramide.h); points solo tiene lo
+	// que se ve con la vista actual y se rehace cuando cambia alguno de los dos,
+	// con a lo mas un vertice por cada ocho pixeles de la ventana.
+	// Con la vista inicial un punto del mundo cae en el mismo pixel de siempre
+	Piramide camino = {0};
+	Trazo trazo = {.presupuesto = 1366 * 768 / 8};
+	const Vista inicial = {683, 384, 1, 1366, 768};
+	Vista vista = inicial;
+	int sucio = 1;
+	piramide_agregar(&camino, x, y);
 	
 	sfVertexArray *points = sfVertexArray_create();
 	sfVertexArray_setPrimitiveType(points, sfLineStrip);
-	sfVertexArray_append(points,tmp);
 	
 	sfVertexArray *trajectory = sfVertexArray_create();
 	sfVertexArray_setPrimitiveType(trajectory, sfLineStrip);
@@ -43,44 +413,118 @@ int main(int argc, char **argv) {
 		sfEvent event;
 		while (sfRenderWindow_pollEvent(window, &event)) {
 			if (event.type == sfEvtClosed) sfRenderWindow_close(window);
+			// La rueda acerca o aleja alrededor del cursor; las flechas mueven
+			// la vista y Inicio la regresa a como estaba
+			else if (event.type == sfEvtMouseWheelScrolled) {
+				double mx = event.mouseWheelScroll.x - vista.ancho / 2.0;
+				double my = event.mouseWheelScroll.y - vista.alto / 2.0;
+				double wx = vista.cx + mx / vista.zoom, wy = vista.cy + my / vista.zoom;
+				vista.zoom *= pow(1.25, event.mouseWheelScroll.delta);
+				vista.cx = wx - mx / vista.zoom;
+				vista.cy = wy - my / vista.zoom;
+				sucio = 1;
+			}
+			else if (event.type == sfEvtKeyPressed) {
+				double salto = 100 / vista.zoom;
+				switch (event.key.code) {
+				case sfKeyLeft:  vista.cx -= salto; break;
+				case sfKeyRight: vista.cx += salto; break;
+				case sfKeyUp:    vista.cy -= salto; break;
+				case sfKeyDown:  vista.cy += salto; break;
+				case sfKeyHome:  vista = inicial; break;
+				default: continue;
+				}
+				sucio = 1;
+			}
 		}
 		
-		if(iteration < count){
-			int Alpha = rand() % Dice;
-			x = (int)(Step * cos(Alpha * Radian)) + x;
-			y = (int)(Step * sin(Alpha * Radian)) + y;
-			
-			
-			x = x > 0 ? (x > 1365 ?
-					(int)(Step * cos((180 - Alpha) * Radian)) + 1365 : x) : 
-					(int)(Step * cos((180 - Alpha) * Radian));
-			y = y > 0 ? (y > 701 ? 
-					(int)(Step * sin(-1 * Alpha * Radian)) + 701 : y) : 
-					(int)(Step * sin(-1 * Alpha * Radian));
-			
-			v.x = x;
-			v.y = y;
+		long leidos = 0;
+		if (reproducir != NULL && iteration < pasos) {
+			long n = pasos - iteration < por_cuadro ? pasos - iteration : por_cuadro;
+			leidos = reproductor_leer(&reproductor, desde + iteration + 1, n, grabado_x, grabado_y);
+			if (leidos <= 0)
+				pasos = iteration;
+		}
+		for (long k = 0; k < por_cuadro && iteration < pasos; k++) {
+			int cruzo = 0;
+			if (reproducir != NULL) {
+				if (k >= leidos) {
+					pasos = iteration;
+					break;
+				}
+				x = grabado_x[k] + origen_x;
+				y = grabado_y[k] + origen_y;
+			} else {
+				distribucion->uno(distribucion, grupo, 0, &dx, &dy);
+				x += dx;
+				y += dy;
+				cruzo = frontera_punto(&frontera, &x, &y);
+			}
 			
-			tmp.position = v;
-			sfVertexArray_append(points,tmp);
-			iteration++;	
+			// Se corta la linea para no cruzar la ventana de lado a lado
+			if (cruzo && frontera.tipo == PERIODICA)
+				piramide_agregar(&camino, NAN, NAN);
+			piramide_agregar(&camino, x, y);
+			iteration++;
+			sucio = 1;
+			if (cruzo && frontera.tipo == ABSORBENTE) {
+				printf("Absorbido en el paso %ld\n", iteration);
+				pasos = iteration;
+			}
 		}
-		else if (iteration == count){
-			start.position = sfVertexArray_getVertex(points, 0) -> position;
-			end.position = sfVertexArray_getVertex(points, count-1) -> position;
-			sfVertexArray_append(trajectory,start);
-			sfVertexArray_append(trajectory,end);
+		if (iteration == pasos){
+			start.position = (sfVector2f){camino.x[0], camino.y[0]};
+			end.position = (sfVector2f){camino.x[camino.n - 1], camino.y[camino.n - 1]};
 			printf("Distancia del punto inicial al final: %.4f unidades\n",
-				   sqrt(pow((start.position.x - end.position.x),2)+
-						pow((start.position.y - end.position.y),2)));
+				   hypot(start.position.x - end.position.x, start.position.y - end.position.y));
 			iteration++;
+			sucio = 1;
 		}
 		
-		
+		if (sucio) {
+			piramide_trazar(&camino, &vista, &trazo);
+			sfVertexArray_clear(points);
+			int cortado = 0;
+			for (size_t i = 0; i < trazo.n; i++) {
+				if (isnan(trazo.x[i])) {
+					// Un vertice transparente en cada orilla del hueco
+					corte.position = v;
+					sfVertexArray_append(points, corte);
+					cortado = 1;
+					continue;
+				}
+				v.x = trazo.x[i];
+				v.y = trazo.y[i];
+				if (cortado) {
+					corte.position = v;
+					sfVertexArray_append(points, corte);
+					cortado = 0;
+				}
+				tmp.position = v;
+				sfVertexArray_append(points, tmp);
+			}
+
+			sfVertexArray_clear(trajectory);
+			if (iteration > pasos) {
+				sfVertex extremo[2] = {start, end};
+				for (int k = 0; k < 2; k++) {
+					extremo[k].position.x = (extremo[k].position.x - vista.cx) * vista.zoom + vista.ancho / 2.0;
+					extremo[k].position.y = (extremo[k].position.y - vista.cy) * vista.zoom + vista.alto / 2.0;
+					sfVertexArray_append(trajectory, extremo[k]);
+				}
+			}
+
+			char titulo[128];
+			snprintf(titulo, sizeof(titulo), "Programa 3: Caminante Aleatorio - %ld pasos, %zu vertices, zoom %.3g, tolerancia %g px",
+			         iteration < pasos ? iteration : pasos, sfVertexArray_getVertexCount(points), vista.zoom,
+			         trazo.tolerancia);
+			sfRenderWindow_setTitle(window, titulo);
+			sucio = 0;
+		}
 		
 		sfRenderWindow_clear(window, sfBlack);
 		sfRenderWindow_drawVertexArray(window, points, NULL);
-		if(iteration >= count) 
+		if(iteration > pasos) 
 			sfRenderWindow_drawVertexArray(window, trajectory, NULL);
 		sfRenderWindow_display(window);
 		sfSleep(T);
@@ -89,6 +533,14 @@ int main(int argc, char **argv) {
 	sfVertexArray_destroy(points);
 	sfVertexArray_destroy(trajectory);
 	sfRenderWindow_destroy(window);
+	piramide_liberar(&camino);
+	trazo_liberar(&trazo);
+	if (reproducir != NULL)
+		reproductor_cerrar(&reproductor);
+	free(distribucion);
+	free(grupo);
+	free(grabado_x);
+	free(grabado_y);
 
 	return 0;
 }
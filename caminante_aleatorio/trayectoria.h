@@ -0,0 +1,339 @@
+#ifndef TRAYECTORIA_H
+#define TRAYECTORIA_H
+
+/*
+ * Grabacion y lectura de trayectorias largas en disco.
+ *
+ * Las posiciones se guardan cuantizadas a 1/escala unidades, como enteros de
+ * 64 bits, y de cada paso solo la diferencia con el anterior en zigzag y
+ * varint (1 o 2 bytes para un paso normal, hasta 10 para un vuelo enorme).
+ * Como se cuantiza la posicion y no el paso, el error no se acumula.
+ *
+ * Cada BLOQUE_TRAYECTORIA pasos forman un bloque que se comprime con zlib por
+ * separado y que empieza con su posicion absoluta, asi que cualquier paso se
+ * alcanza descomprimiendo un solo bloque. Al final va un indice de bloques y
+ * un pie que dice donde empieza:
+ *
+ *     Encabezado | bloque 0 | bloque 1 | ... | relleno | Entrada[] | Pie
+ *
+ * Todo en el orden de bytes de la maquina. El lector mapea el archivo en
+ * memoria, asi que abrir una trayectoria de 10^9 pasos no lee nada todavia.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#define BLOQUE_TRAYECTORIA 65536
+#define MAX_VARINT 10
+#define ESCALA_TRAYECTORIA 256.0
+
+static const char MAGIA_TRAYECTORIA[8] = "CAMINO01";
+static const char MAGIA_INDICE[8] = "INDICE01";
+
+typedef struct {
+	char magia[8];
+	double escala;
+	uint32_t bloque;        // pasos por bloque
+	uint32_t reservado;
+} Encabezado;
+
+typedef struct {
+	uint64_t desplazamiento;    // donde empieza el bloque en el archivo
+	uint32_t comprimido, crudo; // bytes del bloque en disco y descomprimido
+	uint32_t pasos, reservado;
+	int64_t x, y;               // posicion antes del primer paso del bloque
+} Entrada;
+
+typedef struct {
+	uint64_t indice;            // donde empieza el indice
+	uint64_t bloques, pasos;
+	char magia[8];
+} Pie;
+
+typedef struct {
+	FILE *f;
+	double escala;
+	int64_t x, y;               // ultima posicion grabada, cuantizada
+	uint64_t pasos, desplazamiento;
+	uint8_t *crudo, *comprimido;
+	uLong capacidad;            // de 'comprimido'
+	z_stream z;
+	size_t usado;
+	uint32_t en_bloque;
+	Entrada *indice, actual;
+	size_t bloques, entradas;
+} Grabadora;
+
+typedef struct {
+	uint8_t *mapa;
+	size_t largo;
+	double escala;
+	uint32_t bloque;
+	uint64_t pasos, bloques;
+	const Entrada *indice;
+	uint8_t *crudo;
+	int64_t *px, *py;           // posiciones del bloque decodificado
+	uint64_t decodificado;      // numero de ese bloque, o UINT64_MAX
+} Reproductor;
+
+static inline uint8_t *varint_escribir(uint8_t *p, int64_t v){
+	uint64_t z = ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+	while (z >= 0x80) {
+		*p++ = (uint8_t)(z | 0x80);
+		z >>= 7;
+	}
+	*p++ = (uint8_t)z;
+	return p;
+}
+
+static inline const uint8_t *varint_leer(const uint8_t *p, const uint8_t *fin, int64_t *v){
+	uint64_t z = 0;
+	for (int corrimiento = 0; p < fin && corrimiento < 64; corrimiento += 7) {
+		uint8_t b = *p++;
+		z |= (uint64_t)(b & 0x7f) << corrimiento;
+		if (b < 0x80) {
+			*v = (int64_t)(z >> 1) ^ -(int64_t)(z & 1);
+			return p;
+		}
+	}
+	return NULL;
+}
+
+static inline int64_t trayectoria_cuantizar(double v, double escala){
+	return (int64_t)llround(v * escala);
+}
+
+static int grabadora_vaciar(Grabadora *g){
+	if (g->en_bloque == 0)
+		return 0;
+	g->z.next_in = g->crudo;
+	g->z.avail_in = (uInt)g->usado;
+	g->z.next_out = g->comprimido;
+	g->z.avail_out = (uInt)g->capacidad;
+	if (deflate(&g->z, Z_FINISH) != Z_STREAM_END)
+		return -1;
+	uLong comprimido = g->z.total_out;
+	if (deflateReset(&g->z) != Z_OK || fwrite(g->comprimido, 1, comprimido, g->f) != comprimido)
+		return -1;
+
+	if (g->bloques == g->entradas) {
+		size_t entradas = g->entradas ? 2 * g->entradas : 64;
+		Entrada *indice = realloc(g->indice, entradas * sizeof(Entrada));
+		if (indice == NULL)
+			return -1;
+		g->indice = indice;
+		g->entradas = entradas;
+	}
+	g->actual.desplazamiento = g->desplazamiento;
+	g->actual.comprimido = (uint32_t)comprimido;
+	g->actual.crudo = (uint32_t)g->usado;
+	g->actual.pasos = g->en_bloque;
+	g->indice[g->bloques++] = g->actual;
+	g->desplazamiento += comprimido;
+	g->usado = 0;
+	g->en_bloque = 0;
+	return 0;
+}
+
+/*
+ * Abre 'nombre' para grabar una trayectoria que empieza en (x, y), con
+ * posiciones redondeadas a 1/escala. 'estrategia' es la de zlib: con pasos
+ * que se repiten (en red o en angulo hay pocos distintos) conviene
+ * Z_DEFAULT_STRATEGY; si casi nunca se repiten, Z_HUFFMAN_ONLY comprime igual
+ * y mas rapido. Devuelve -1 si no se pudo.
+ */
+int grabadora_abrir(Grabadora *g, const char *nombre, double escala, double x, double y, int estrategia){
+	memset(g, 0, sizeof(*g));
+	g->escala = escala;
+	g->x = trayectoria_cuantizar(x, escala);
+	g->y = trayectoria_cuantizar(y, escala);
+	g->capacidad = compressBound((uLong)BLOQUE_TRAYECTORIA * 2 * MAX_VARINT);
+	g->crudo = malloc((size_t)BLOQUE_TRAYECTORIA * 2 * MAX_VARINT);
+	g->comprimido = malloc(g->capacidad);
+	g->f = fopen(nombre, "wb");
+
+	// El mismo compresor sirve para todos los bloques
+	int z = deflateInit2(&g->z, Z_BEST_SPEED, Z_DEFLATED, 15, 8, estrategia);
+
+	Encabezado e = {{0}, escala, BLOQUE_TRAYECTORIA, 0};
+	memcpy(e.magia, MAGIA_TRAYECTORIA, sizeof(e.magia));
+	if (z != Z_OK || g->crudo == NULL || g->comprimido == NULL || g->f == NULL ||
+	    fwrite(&e, sizeof(e), 1, g->f) != 1) {
+		if (z == Z_OK)
+			deflateEnd(&g->z);
+		if (g->f != NULL)
+			fclose(g->f);
+		free(g->crudo);
+		free(g->comprimido);
+		return -1;
+	}
+	g->desplazamiento = sizeof(e);
+	return 0;
+}
+
+// Agrega la posicion tras un paso mas.
+int grabadora_paso(Grabadora *g, double x, double y){
+	if (g->en_bloque == 0) {
+		g->actual.x = g->x;
+		g->actual.y = g->y;
+	}
+	int64_t qx = trayectoria_cuantizar(x, g->escala), qy = trayectoria_cuantizar(y, g->escala);
+	uint8_t *p = varint_escribir(g->crudo + g->usado, qx - g->x);
+	p = varint_escribir(p, qy - g->y);
+	g->usado = p - g->crudo;
+	g->x = qx;
+	g->y = qy;
+	g->pasos++;
+	return ++g->en_bloque == BLOQUE_TRAYECTORIA ? grabadora_vaciar(g) : 0;
+}
+
+// Escribe el ultimo bloque, el indice y el pie. Devuelve -1 si algo fallo.
+int grabadora_cerrar(Grabadora *g){
+	int error = grabadora_vaciar(g);
+	static const uint8_t relleno[8] = {0};
+	size_t sobra = (8 - g->desplazamiento % 8) % 8;
+	Pie pie = {g->desplazamiento + sobra, g->bloques, g->pasos, {0}};
+	memcpy(pie.magia, MAGIA_INDICE, sizeof(pie.magia));
+
+	// Sin pasos queda un bloque vacio que guarda la posicion inicial
+	if (g->bloques == 0 && error == 0) {
+		g->actual.x = g->x;
+		g->actual.y = g->y;
+		g->actual.desplazamiento = g->desplazamiento;
+		g->indice = malloc(sizeof(Entrada));
+		if (g->indice == NULL)
+			error = -1;
+		else
+			g->indice[g->bloques++] = g->actual;
+		pie.bloques = g->bloques;
+	}
+	if (error == 0)
+		error = fwrite(relleno, 1, sobra, g->f) != sobra ||
+		        fwrite(g->indice, sizeof(Entrada), g->bloques, g->f) != g->bloques ||
+		        fwrite(&pie, sizeof(pie), 1, g->f) != 1 ? -1 : 0;
+	error |= fclose(g->f) != 0 ? -1 : 0;
+	deflateEnd(&g->z);
+	free(g->crudo);
+	free(g->comprimido);
+	free(g->indice);
+	return error;
+}
+
+void reproductor_cerrar(Reproductor *r){
+	if (r->mapa != NULL)
+		munmap(r->mapa, r->largo);
+	free(r->crudo);
+	free(r->px);
+	free(r->py);
+}
+
+// Mapea 'nombre' y revisa su encabezado y su indice. Devuelve -1 si no es valido.
+int reproductor_abrir(Reproductor *r, const char *nombre){
+	struct stat datos;
+	Encabezado e;
+	Pie pie;
+
+	memset(r, 0, sizeof(*r));
+	r->decodificado = UINT64_MAX;
+	int fd = open(nombre, O_RDONLY);
+	if (fd < 0)
+		return -1;
+	if (fstat(fd, &datos) != 0 || (size_t)datos.st_size < sizeof(e) + sizeof(pie)) {
+		close(fd);
+		return -1;
+	}
+	r->largo = datos.st_size;
+	r->mapa = mmap(NULL, r->largo, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (r->mapa == MAP_FAILED) {
+		r->mapa = NULL;
+		return -1;
+	}
+
+	memcpy(&e, r->mapa, sizeof(e));
+	memcpy(&pie, r->mapa + r->largo - sizeof(pie), sizeof(pie));
+	if (memcmp(e.magia, MAGIA_TRAYECTORIA, sizeof(e.magia)) != 0 ||
+	    memcmp(pie.magia, MAGIA_INDICE, sizeof(pie.magia)) != 0 || pie.indice % 8 != 0 ||
+	    pie.bloques == 0 || e.bloque == 0 || e.bloque > BLOQUE_TRAYECTORIA ||
+	    pie.indice + pie.bloques * sizeof(Entrada) != r->largo - sizeof(pie)) {
+		reproductor_cerrar(r);
+		return -1;
+	}
+	r->escala = e.escala;
+	r->bloque = e.bloque;
+	r->pasos = pie.pasos;
+	r->bloques = pie.bloques;
+	r->indice = (const Entrada *)(r->mapa + pie.indice);
+	for (uint64_t k = 0; k < r->bloques; k++)
+		if (r->indice[k].desplazamiento + r->indice[k].comprimido > pie.indice ||
+		    r->indice[k].crudo > (size_t)r->bloque * 2 * MAX_VARINT || r->indice[k].pasos > r->bloque) {
+			reproductor_cerrar(r);
+			return -1;
+		}
+
+	r->crudo = malloc((size_t)r->bloque * 2 * MAX_VARINT);
+	r->px = malloc(((size_t)r->bloque + 1) * sizeof(int64_t));
+	r->py = malloc(((size_t)r->bloque + 1) * sizeof(int64_t));
+	if (r->crudo == NULL || r->px == NULL || r->py == NULL) {
+		reproductor_cerrar(r);
+		return -1;
+	}
+	madvise(r->mapa, r->largo, MADV_RANDOM);
+	return 0;
+}
+
+// Deja en px[], py[] las posiciones del bloque k, desde la anterior a su primer paso.
+static int reproductor_bloque(Reproductor *r, uint64_t k){
+	if (r->decodificado == k)
+		return 0;
+	const Entrada *e = &r->indice[k];
+	uLongf crudo = e->crudo;
+	if (e->pasos > 0 &&
+	    (uncompress(r->crudo, &crudo, r->mapa + e->desplazamiento, e->comprimido) != Z_OK ||
+	     crudo != e->crudo))
+		return -1;
+
+	const uint8_t *p = r->crudo, *fin = r->crudo + crudo;
+	r->px[0] = e->x;
+	r->py[0] = e->y;
+	for (uint32_t i = 1; i <= e->pasos; i++) {
+		int64_t dx, dy;
+		if ((p = varint_leer(p, fin, &dx)) == NULL || (p = varint_leer(p, fin, &dy)) == NULL)
+			return -1;
+		r->px[i] = r->px[i - 1] + dx;
+		r->py[i] = r->py[i - 1] + dy;
+	}
+	r->decodificado = k;
+	return 0;
+}
+
+/*
+ * Posiciones tras los pasos desde .. desde + n - 1 (la 0 es la inicial).
+ * Devuelve cuantas leyo, menos de n si la trayectoria se acaba, o -1 si el
+ * archivo esta danado.
+ */
+long reproductor_leer(Reproductor *r, uint64_t desde, long n, double *x, double *y){
+	long leidas = 0;
+	while (leidas < n && desde + leidas <= r->pasos) {
+		uint64_t paso = desde + leidas;
+		uint64_t k = paso == 0 ? 0 : (paso - 1) / r->bloque;
+		if (reproductor_bloque(r, k) != 0)
+			return -1;
+		uint64_t i = paso - k * r->bloque;
+		for (; leidas < n && i <= r->indice[k].pasos; i++, leidas++) {
+			x[leidas] = r->px[i] / r->escala;
+			y[leidas] = r->py[i] / r->escala;
+		}
+	}
+	return leidas;
+}
+
+#endif
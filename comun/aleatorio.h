@@ -0,0 +1,147 @@
+#ifndef ALEATORIO_H
+#define ALEATORIO_H
+
+/*
+ * Motores de numeros aleatorios compartidos por los programas del curso.
+ *
+ * Se elige el motor en tiempo de compilacion:
+ *   (por defecto)     xoshiro256**, los flujos se separan con saltos de 2^128.
+ *   -DMOTOR_PHILOX    Philox4x32-10, basado en contador; el flujo va en la llave.
+ *
+ * Ambos exponen la misma interfaz: generador_iniciar(g, semilla, flujo) y
+ * generador_u64(g). Dos flujos distintos con la misma semilla no se traslapan,
+ * por lo que cada hilo puede tener el suyo y la corrida es reproducible.
+ */
+
+#include <stdint.h>
+
+static inline uint64_t splitmix64(uint64_t *x){
+	uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+#ifndef MOTOR_PHILOX
+
+typedef struct {
+	uint64_t s[4];
+} Generador;
+
+static inline uint64_t rotl64(uint64_t x, int k){
+	return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t generador_u64(Generador *g){
+	uint64_t *s = g->s;
+	uint64_t resultado = rotl64(s[1] * 5, 7) * 9;
+	uint64_t t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotl64(s[3], 45);
+
+	return resultado;
+}
+
+// Equivale a 2^128 llamadas a generador_u64.
+static inline void generador_salto(Generador *g){
+	static const uint64_t SALTO[] = {
+		0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+		0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+	};
+	uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+
+	for (int i = 0; i < 4; i++)
+		for (int b = 0; b < 64; b++) {
+			if (SALTO[i] & (1ULL << b)) {
+				s0 ^= g->s[0];
+				s1 ^= g->s[1];
+				s2 ^= g->s[2];
+				s3 ^= g->s[3];
+			}
+			generador_u64(g);
+		}
+
+	g->s[0] = s0;
+	g->s[1] = s1;
+	g->s[2] = s2;
+	g->s[3] = s3;
+}
+
+static inline void generador_iniciar(Generador *g, uint64_t semilla, uint64_t flujo){
+	for (int i = 0; i < 4; i++)
+		g->s[i] = splitmix64(&semilla);
+	while (flujo--)
+		generador_salto(g);
+}
+
+#else
+
+typedef struct {
+	uint32_t llave[2];
+	uint32_t contador[4];
+	uint32_t salida[4];
+	int restantes;
+} Generador;
+
+static inline void philox_bloque(Generador *g){
+	uint32_t c0 = g->contador[0], c1 = g->contador[1];
+	uint32_t c2 = g->contador[2], c3 = g->contador[3];
+	uint32_t k0 = g->llave[0], k1 = g->llave[1];
+
+	for (int r = 0; r < 10; r++) {
+		uint64_t p0 = (uint64_t)0xD2511F53u * c0;
+		uint64_t p1 = (uint64_t)0xCD9E8D57u * c2;
+		uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+		uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+		c0 = n0;
+		c1 = (uint32_t)p1;
+		c2 = n2;
+		c3 = (uint32_t)p0;
+		k0 += 0x9E3779B9u;
+		k1 += 0xBB67AE85u;
+	}
+
+	g->salida[0] = c0;
+	g->salida[1] = c1;
+	g->salida[2] = c2;
+	g->salida[3] = c3;
+	g->restantes = 2;
+
+	// El contador de 128 bits avanza en sus dos palabras bajas; las altas
+	// guardan el numero de flujo.
+	if (++g->contador[0] == 0)
+		++g->contador[1];
+}
+
+static inline uint64_t generador_u64(Generador *g){
+	if (g->restantes == 0)
+		philox_bloque(g);
+	g->restantes--;
+	int k = 2 * g->restantes;
+	return ((uint64_t)g->salida[k] << 32) | g->salida[k + 1];
+}
+
+static inline void generador_iniciar(Generador *g, uint64_t semilla, uint64_t flujo){
+	uint64_t mezcla = splitmix64(&semilla);
+	g->llave[0] = (uint32_t)mezcla;
+	g->llave[1] = (uint32_t)(mezcla >> 32);
+	g->contador[0] = 0;
+	g->contador[1] = 0;
+	g->contador[2] = (uint32_t)flujo;
+	g->contador[3] = (uint32_t)(flujo >> 32);
+	g->restantes = 0;
+}
+
+#endif
+
+// Flotante uniforme en [0, 1) con 53 bits de precision.
+static inline double generador_uniforme(Generador *g){
+	return (generador_u64(g) >> 11) * 0x1.0p-53;
+}
+
+#endif
@@ -0,0 +1,221 @@
+#ifndef GRAFICA_H
+#define GRAFICA_H
+
+/*
+ * Graficas en SVG escritas directamente desde C, sin Python ni bibliotecas:
+ * barras (frecuencia por cara) e histograma de densidad con una curva
+ * teorica encima. Los datos se piden por medio de una funcion para no tener
+ * que copiar tallies enormes; con mas de MAX_BARRAS categorias cada barra
+ * muestra el promedio de un grupo de categorias consecutivas.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define ANCHO_SVG 1000
+#define ALTO_SVG 600
+#define MARGEN_IZQ 90
+#define MARGEN_DER 30
+#define MARGEN_ARR 60
+#define MARGEN_ABA 70
+#define MAX_BARRAS 500
+
+static void svg_texto(FILE *f, double x, double y, int tam, const char *ancla,
+                      double rotacion, const char *texto){
+	fprintf(f, "<text x=\"%.1f\" y=\"%.1f\" font-family=\"sans-serif\" font-size=\"%d\" "
+	           "text-anchor=\"%s\"", x, y, tam, ancla);
+	if (rotacion != 0)
+		fprintf(f, " transform=\"rotate(%.0f %.1f %.1f)\"", rotacion, x, y);
+	fputc('>', f);
+	for (; *texto; texto++)
+		switch (*texto) {
+		case '<': fputs("&lt;", f); break;
+		case '>': fputs("&gt;", f); break;
+		case '&': fputs("&amp;", f); break;
+		default: fputc(*texto, f);
+		}
+	fputs("</text>\n", f);
+}
+
+// Paso "bonito" (1, 2 o 5 por potencia de 10) para unas 'marcas' divisiones.
+static double paso_eje(double rango, int marcas){
+	double bruto = rango / marcas, base = pow(10, floor(log10(bruto)));
+	double r = bruto / base;
+	return (r <= 1 ? 1 : r <= 2 ? 2 : r <= 5 ? 5 : 10) * base;
+}
+
+// Encabezado, titulo, etiquetas de ejes y rejilla horizontal de 0 a y_max.
+static void svg_marco(FILE *f, const char *titulo, const char *eje_x, const char *eje_y,
+                      double y_max){
+	int ancho = ANCHO_SVG - MARGEN_IZQ - MARGEN_DER, alto = ALTO_SVG - MARGEN_ARR - MARGEN_ABA;
+	char numero[32];
+
+	fprintf(f, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" "
+	           "viewBox=\"0 0 %d %d\">\n", ANCHO_SVG, ALTO_SVG, ANCHO_SVG, ALTO_SVG);
+	fprintf(f, "<rect width=\"100%%\" height=\"100%%\" fill=\"white\"/>\n");
+	svg_texto(f, ANCHO_SVG / 2.0, MARGEN_ARR / 2.0, 20, "middle", 0, titulo);
+	svg_texto(f, MARGEN_IZQ + ancho / 2.0, ALTO_SVG - 20, 14, "middle", 0, eje_x);
+	svg_texto(f, 25, MARGEN_ARR + alto / 2.0, 14, "middle", -90, eje_y);
+
+	double paso = paso_eje(y_max, 8);
+	for (double y = 0; y <= y_max * 1.0001; y += paso) {
+		double py = MARGEN_ARR + alto * (1 - y / y_max);
+		fprintf(f, "<line x1=\"%d\" y1=\"%.1f\" x2=\"%d\" y2=\"%.1f\" stroke=\"#bbb\" "
+		           "stroke-dasharray=\"4 3\"/>\n", MARGEN_IZQ, py, MARGEN_IZQ + ancho, py);
+		snprintf(numero, sizeof(numero), "%g", y);
+		svg_texto(f, MARGEN_IZQ - 8, py + 4, 12, "end", 0, numero);
+	}
+	fprintf(f, "<line x1=\"%d\" y1=\"%d\" x2=\"%d\" y2=\"%d\" stroke=\"black\"/>\n",
+	        MARGEN_IZQ, MARGEN_ARR, MARGEN_IZQ, MARGEN_ARR + alto);
+	fprintf(f, "<line x1=\"%d\" y1=\"%d\" x2=\"%d\" y2=\"%d\" stroke=\"black\"/>\n",
+	        MARGEN_IZQ, MARGEN_ARR + alto, MARGEN_IZQ + ancho, MARGEN_ARR + alto);
+}
+
+/*
+ * Grafica de barras de n categorias; la categoria i se rotula como
+ * primera + i y su altura es valor(i, datos). Devuelve -1 si no se pudo
+ * escribir el archivo.
+ */
+int grafica_barras(const char *nombre, const char *titulo, const char *eje_x, const char *eje_y,
+                   size_t n, long long primera, double (*valor)(size_t, const void *),
+                   const void *datos){
+	size_t grupo = (n + MAX_BARRAS - 1) / MAX_BARRAS, barras = (n + grupo - 1) / grupo;
+	double *alturas = malloc(barras * sizeof(double)), y_max = 0;
+	FILE *f = fopen(nombre, "w");
+	if (alturas == NULL || f == NULL) {
+		free(alturas);
+		if (f != NULL)
+			fclose(f);
+		return -1;
+	}
+
+	for (size_t b = 0; b < barras; b++) {
+		size_t desde = b * grupo, hasta = desde + grupo < n ? desde + grupo : n;
+		double suma = 0;
+		for (size_t i = desde; i < hasta; i++)
+			suma += valor(i, datos);
+		alturas[b] = suma / (hasta - desde);
+		if (alturas[b] > y_max)
+			y_max = alturas[b];
+	}
+	if (y_max <= 0)
+		y_max = 1;
+	y_max = ceil(y_max * 1.05 / paso_eje(y_max * 1.05, 8)) * paso_eje(y_max * 1.05, 8);
+
+	svg_marco(f, titulo, eje_x, eje_y, y_max);
+
+	int ancho = ANCHO_SVG - MARGEN_IZQ - MARGEN_DER, alto = ALTO_SVG - MARGEN_ARR - MARGEN_ABA;
+	double ancho_barra = (double)ancho / barras;
+	size_t cada = barras > 20 ? barras / 10 : 1;
+	char etiqueta[64];
+
+	for (size_t b = 0; b < barras; b++) {
+		double h = alto * alturas[b] / y_max, x = MARGEN_IZQ + b * ancho_barra;
+		fprintf(f, "<rect x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\" fill=\"skyblue\"",
+		        x + ancho_barra * 0.1, MARGEN_ARR + alto - h, ancho_barra * 0.8, h);
+		fprintf(f, barras <= 100 ? " stroke=\"black\"/>\n" : "/>\n");
+
+		if (b % cada == 0) {
+			if (grupo == 1)
+				snprintf(etiqueta, sizeof(etiqueta), "%lld", primera + (long long)b);
+			else
+				snprintf(etiqueta, sizeof(etiqueta), "%lld", primera + (long long)(b * grupo));
+			svg_texto(f, x + ancho_barra / 2, MARGEN_ARR + alto + 18, 12, "middle", 0, etiqueta);
+		}
+	}
+
+	fprintf(f, "</svg>\n");
+	free(alturas);
+	return fclose(f) == 0 ? 0 : -1;
+}
+
+/*
+ * Histograma de densidad de 'datos' con 'clases' clases, y encima la curva
+ * densidad(x, parametro) en rojo con su leyenda. Con densidad NULL solo van
+ * las barras.
+ */
+int grafica_histograma(const char *nombre, const char *titulo, const char *eje_x, const char *eje_y,
+                       const double *datos, size_t n, int clases,
+                       double (*densidad)(double, const void *), const void *parametro,
+                       const char *leyenda){
+	double minimo = INFINITY, maximo = -INFINITY;
+	for (size_t i = 0; i < n; i++) {
+		if (datos[i] < minimo) minimo = datos[i];
+		if (datos[i] > maximo) maximo = datos[i];
+	}
+	if (n == 0 || clases <= 0)
+		return -1;
+	if (maximo <= minimo)
+		maximo = minimo + 1;
+
+	double *alturas = calloc(clases, sizeof(double)), ancho_clase = (maximo - minimo) / clases;
+	FILE *f = fopen(nombre, "w");
+	if (alturas == NULL || f == NULL) {
+		free(alturas);
+		if (f != NULL)
+			fclose(f);
+		return -1;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		int c = (int)((datos[i] - minimo) / ancho_clase);
+		alturas[c < clases ? c : clases - 1] += 1;
+	}
+
+	double y_max = 0;
+	for (int c = 0; c < clases; c++) {
+		alturas[c] /= n * ancho_clase;
+		if (alturas[c] > y_max)
+			y_max = alturas[c];
+	}
+	for (int j = 0; densidad != NULL && j <= 200; j++) {
+		double y = densidad(minimo + (maximo - minimo) * j / 200, parametro);
+		if (y > y_max)
+			y_max = y;
+	}
+	y_max = ceil(y_max * 1.05 / paso_eje(y_max * 1.05, 8)) * paso_eje(y_max * 1.05, 8);
+
+	svg_marco(f, titulo, eje_x, eje_y, y_max);
+
+	int ancho = ANCHO_SVG - MARGEN_IZQ - MARGEN_DER, alto = ALTO_SVG - MARGEN_ARR - MARGEN_ABA;
+	for (int c = 0; c < clases; c++) {
+		double h = alto * alturas[c] / y_max;
+		fprintf(f, "<rect x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\" fill=\"#3498db\" "
+		           "fill-opacity=\"0.7\" stroke=\"white\"/>\n",
+		        MARGEN_IZQ + (double)ancho * c / clases, MARGEN_ARR + alto - h, (double)ancho / clases, h);
+	}
+
+	if (densidad != NULL) {
+		fprintf(f, "<polyline fill=\"none\" stroke=\"red\" stroke-width=\"3\" points=\"");
+		for (int j = 0; j <= 200; j++) {
+			double y = densidad(minimo + (maximo - minimo) * j / 200, parametro);
+			fprintf(f, "%.2f,%.2f ", MARGEN_IZQ + ancho * j / 200.0, MARGEN_ARR + alto * (1 - y / y_max));
+		}
+		fprintf(f, "\"/>\n");
+	}
+
+	double paso = paso_eje(maximo - minimo, 10);
+	char numero[32];
+	for (double x = ceil(minimo / paso) * paso; x <= maximo; x += paso) {
+		snprintf(numero, sizeof(numero), "%g", fabs(x) < paso * 1e-9 ? 0 : x);
+		svg_texto(f, MARGEN_IZQ + ancho * (x - minimo) / (maximo - minimo), MARGEN_ARR + alto + 18,
+		          12, "middle", 0, numero);
+	}
+
+	int lx = ANCHO_SVG - MARGEN_DER - 260, ly = MARGEN_ARR + 20;
+	fprintf(f, "<rect x=\"%d\" y=\"%d\" width=\"20\" height=\"12\" fill=\"#3498db\" fill-opacity=\"0.7\"/>\n",
+	        lx, ly - 10);
+	svg_texto(f, lx + 28, ly, 13, "start", 0, "Frecuencia de datos");
+	if (densidad != NULL) {
+		fprintf(f, "<line x1=\"%d\" y1=\"%d\" x2=\"%d\" y2=\"%d\" stroke=\"red\" stroke-width=\"3\"/>\n",
+		        lx, ly + 16, lx + 20, ly + 16);
+		svg_texto(f, lx + 28, ly + 20, 13, "start", 0, leyenda);
+	}
+
+	fprintf(f, "</svg>\n");
+	free(alturas);
+	return fclose(f) == 0 ? 0 : -1;
+}
+
+#endif
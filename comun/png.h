@@ -0,0 +1,139 @@
+#ifndef PNG_H
+#define PNG_H
+
+/*
+ * Escritura de imagenes PNG en escala de grises de 16 bits, sin bibliotecas.
+ *
+ * Los datos van en bloques deflate "almacenados" (sin comprimir), que
+ * cualquier lector de PNG acepta; el archivo pesa lo mismo que la imagen en
+ * crudo, pero no hace falta zlib. El IDAT se escribe en un solo fragmento cuyo
+ * largo se conoce de antemano, y los CRC y el Adler-32 se calculan conforme
+ * se va escribiendo, asi que no se arma la imagen completa en memoria.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define PNG_BLOQUE 65535
+
+typedef struct {
+	FILE *f;
+	uint32_t crc;
+	uint32_t adler_a, adler_b;
+	uint32_t en_bloque;    // bytes que faltan del bloque deflate actual
+	uint64_t restantes;    // bytes crudos que faltan en total
+} Png;
+
+static uint32_t png_tabla_crc[256];
+
+static void png_iniciar_crc(void){
+	for (uint32_t n = 0; n < 256; n++) {
+		uint32_t c = n;
+		for (int k = 0; k < 8; k++)
+			c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+		png_tabla_crc[n] = c;
+	}
+}
+
+static void png_bytes(Png *p, const uint8_t *datos, size_t n){
+	for (size_t i = 0; i < n; i++)
+		p->crc = png_tabla_crc[(p->crc ^ datos[i]) & 0xff] ^ (p->crc >> 8);
+	fwrite(datos, 1, n, p->f);
+}
+
+static void png_u32(Png *p, uint32_t v){
+	uint8_t b[4] = {v >> 24, v >> 16, v >> 8, v};
+	png_bytes(p, b, 4);
+}
+
+static void png_abrir_fragmento(Png *p, const char *tipo, uint32_t largo){
+	uint8_t b[4] = {largo >> 24, largo >> 16, largo >> 8, largo};
+	fwrite(b, 1, 4, p->f);
+	p->crc = 0xffffffffu;
+	png_bytes(p, (const uint8_t *)tipo, 4);
+}
+
+static void png_cerrar_fragmento(Png *p){
+	uint32_t crc = p->crc ^ 0xffffffffu;
+	uint8_t b[4] = {crc >> 24, crc >> 16, crc >> 8, crc};
+	fwrite(b, 1, 4, p->f);
+}
+
+// Agrega bytes crudos al flujo zlib, abriendo bloques almacenados cuando toca.
+static void png_crudo(Png *p, const uint8_t *datos, size_t n){
+	while (n > 0) {
+		if (p->en_bloque == 0) {
+			uint16_t largo = p->restantes < PNG_BLOQUE ? (uint16_t)p->restantes : PNG_BLOQUE;
+			uint8_t cabeza[5] = {p->restantes == largo, largo, largo >> 8,
+			                     (uint8_t)~largo, (uint8_t)(~largo >> 8)};
+			png_bytes(p, cabeza, 5);
+			p->en_bloque = largo;
+		}
+		size_t tramo = n < p->en_bloque ? n : p->en_bloque;
+		for (size_t i = 0; i < tramo; i++) {
+			p->adler_a = (p->adler_a + datos[i]) % 65521;
+			p->adler_b = (p->adler_b + p->adler_a) % 65521;
+		}
+		png_bytes(p, datos, tramo);
+		p->en_bloque -= tramo;
+		p->restantes -= tramo;
+		datos += tramo;
+		n -= tramo;
+	}
+}
+
+/*
+ * Escribe una imagen de ancho x alto con un valor de 16 bits por pixel,
+ * renglon por renglon desde arriba. Devuelve -1 si no se pudo escribir.
+ */
+int png_gris16(const char *nombre, const uint16_t *pixeles, uint32_t ancho, uint32_t alto){
+	uint64_t crudo = (uint64_t)alto * (1 + 2 * (uint64_t)ancho);
+	uint64_t bloques = (crudo + PNG_BLOQUE - 1) / PNG_BLOQUE;
+	uint64_t largo_idat = 2 + crudo + 5 * bloques + 4;
+	if (ancho == 0 || alto == 0 || largo_idat > 0x7fffffffu)
+		return -1;
+
+	Png p = {fopen(nombre, "wb"), 0, 1, 0, 0, crudo};
+	if (p.f == NULL)
+		return -1;
+	png_iniciar_crc();
+
+	static const uint8_t firma[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+	fwrite(firma, 1, 8, p.f);
+
+	png_abrir_fragmento(&p, "IHDR", 13);
+	png_u32(&p, ancho);
+	png_u32(&p, alto);
+	const uint8_t formato[5] = {16, 0, 0, 0, 0};   // 16 bits, gris, sin entrelazado
+	png_bytes(&p, formato, 5);
+	png_cerrar_fragmento(&p);
+
+	png_abrir_fragmento(&p, "IDAT", (uint32_t)largo_idat);
+	const uint8_t zlib[2] = {0x78, 0x01};
+	png_bytes(&p, zlib, 2);
+
+	uint8_t renglon[2 * 4096];
+	for (uint32_t y = 0; y < alto; y++) {
+		const uint16_t *fila = pixeles + (size_t)y * ancho;
+		uint8_t filtro = 0;
+		png_crudo(&p, &filtro, 1);
+		for (uint32_t x = 0; x < ancho; x += 4096) {
+			uint32_t tramo = ancho - x < 4096 ? ancho - x : 4096;
+			for (uint32_t i = 0; i < tramo; i++) {
+				renglon[2 * i] = fila[x + i] >> 8;
+				renglon[2 * i + 1] = fila[x + i] & 0xff;
+			}
+			png_crudo(&p, renglon, 2 * tramo);
+		}
+	}
+	png_u32(&p, (p.adler_b << 16) | p.adler_a);
+	png_cerrar_fragmento(&p);
+
+	png_abrir_fragmento(&p, "IEND", 0);
+	png_cerrar_fragmento(&p);
+
+	int error = ferror(p.f);
+	return fclose(p.f) == 0 && !error ? 0 : -1;
+}
+
+#endif
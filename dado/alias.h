@@ -0,0 +1,158 @@
+#ifndef ALIAS_H
+#define ALIAS_H
+
+/*
+ * Dado cargado con el metodo de alias de Walker (construccion de Vose).
+ *
+ * La tabla se arma en O(n) y cada tiro cuesta O(1): se escoge una columna al
+ * azar y se compara un entero de 32 bits contra su umbral; si lo supera sale
+ * el alias de esa columna. Umbral y alias van juntos en 8 bytes para que cada
+ * tiro toque una sola linea de cache aun con millones de caras.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "dado.h"
+
+typedef struct {
+	uint32_t umbral;   // P(quedarse en la columna) * 2^32
+	uint32_t alias;    // cara (desde 1) que sale si no
+} Columna;
+
+typedef struct {
+	uint32_t n;
+	Columna *columnas;
+	double *probabilidad;   // pesos normalizados, probabilidad[cara - 1]
+} TablaAlias;
+
+int alias_construir(TablaAlias *t, const double *pesos, uint32_t n){
+	double total = 0;
+	for (uint32_t c = 0; c < n; c++) {
+		if (!(pesos[c] >= 0))
+			return -1;
+		total += pesos[c];
+	}
+	if (n == 0 || total <= 0)
+		return -1;
+
+	t->n = n;
+	t->columnas = malloc(n * sizeof(Columna));
+	t->probabilidad = malloc(n * sizeof(double));
+	double *escalado = malloc(n * sizeof(double));
+	uint32_t *chicos = malloc(n * sizeof(uint32_t));
+	uint32_t *grandes = malloc(n * sizeof(uint32_t));
+	if (t->columnas == NULL || t->probabilidad == NULL || escalado == NULL ||
+	    chicos == NULL || grandes == NULL) {
+		free(t->columnas);
+		free(t->probabilidad);
+		free(escalado);
+		free(chicos);
+		free(grandes);
+		return -1;
+	}
+
+	uint32_t nchicos = 0, ngrandes = 0;
+	for (uint32_t c = 0; c < n; c++) {
+		t->probabilidad[c] = pesos[c] / total;
+		escalado[c] = t->probabilidad[c] * n;
+		if (escalado[c] < 1)
+			chicos[nchicos++] = c;
+		else
+			grandes[ngrandes++] = c;
+	}
+
+	// Cada columna chica se completa con un pedazo de una grande
+	while (nchicos > 0 && ngrandes > 0) {
+		uint32_t s = chicos[--nchicos], l = grandes[ngrandes - 1];
+		double u = escalado[s] * 4294967296.0;
+		t->columnas[s].umbral = u >= 4294967295.0 ? UINT32_MAX : (uint32_t)u;
+		t->columnas[s].alias = l + 1;
+		escalado[l] -= 1 - escalado[s];
+		if (escalado[l] < 1) {
+			ngrandes--;
+			chicos[nchicos++] = l;
+		}
+	}
+
+	// Lo que queda vale 1 salvo por redondeo: la columna siempre se queda
+	while (ngrandes > 0) {
+		uint32_t l = grandes[--ngrandes];
+		t->columnas[l].umbral = UINT32_MAX;
+		t->columnas[l].alias = l + 1;
+	}
+	while (nchicos > 0) {
+		uint32_t s = chicos[--nchicos];
+		t->columnas[s].umbral = UINT32_MAX;
+		t->columnas[s].alias = s + 1;
+	}
+
+	free(escalado);
+	free(chicos);
+	free(grandes);
+	return 0;
+}
+
+/*
+ * Lee un peso por renglon (los renglones vacios o que empiezan con # se
+ * ignoran) y arma la tabla. Devuelve -1 si el archivo no se puede leer o los
+ * pesos no son validos.
+ */
+int alias_cargar(TablaAlias *t, const char *nombre){
+	FILE *archivo = fopen(nombre, "r");
+	if (archivo == NULL)
+		return -1;
+
+	size_t n = 0, capacidad = 1024;
+	double *pesos = malloc(capacidad * sizeof(double));
+	char linea[128];
+
+	while (pesos != NULL && fgets(linea, sizeof(linea), archivo)) {
+		char *fin;
+		double peso = strtod(linea, &fin);
+		if (fin == linea)
+			continue;
+		if (n == capacidad) {
+			double *mas = realloc(pesos, 2 * capacidad * sizeof(double));
+			if (mas == NULL) {
+				free(pesos);
+				pesos = NULL;
+				break;
+			}
+			pesos = mas;
+			capacidad *= 2;
+		}
+		pesos[n++] = peso;
+	}
+	fclose(archivo);
+
+	if (pesos == NULL || n > UINT32_MAX) {
+		free(pesos);
+		return -1;
+	}
+	int resultado = alias_construir(t, pesos, (uint32_t)n);
+	free(pesos);
+	return resultado;
+}
+
+void alias_liberar(TablaAlias *t){
+	free(t->columnas);
+	free(t->probabilidad);
+}
+
+// Llena lote[0..cantidad) con tiros del dado cargado (caras desde 1).
+void lanzamientos_alias(Generador *g, const TablaAlias *t, uint32_t *lote, size_t cantidad){
+	lanzamientos(g, (int)t->n, lote, cantidad);
+
+	for (size_t k = 0; k < cantidad; k += 2) {
+		uint64_t r = generador_u64(g);
+		Columna c = t->columnas[lote[k] - 1];
+		lote[k] = (uint32_t)r < c.umbral ? lote[k] : c.alias;
+		if (k + 1 < cantidad) {
+			c = t->columnas[lote[k + 1] - 1];
+			lote[k + 1] = (uint32_t)(r >> 32) < c.umbral ? lote[k + 1] : c.alias;
+		}
+	}
+}
+
+#endif
@@ -1,3 +1,126 @@
-int lanzamiento(int n){
-	return (rand() % n) + 1;
+#ifndef DADO_H
+#define DADO_H
+
+#include <stddef.h>
+#include "../comun/aleatorio.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define DADO_SIMD
+#endif
+
+// Entero uniforme en [1, n] sin sesgo (multiplicacion y desplazamiento de Lemire).
+int lanzamiento(Generador *g, int n){
+	uint64_t m = (uint64_t)(uint32_t)generador_u64(g) * (uint32_t)n;
+
+	if ((uint32_t)m < (uint32_t)n) {
+		uint32_t umbral = -(uint32_t)n % (uint32_t)n;
+		while ((uint32_t)m < umbral)
+			m = (uint64_t)(uint32_t)generador_u64(g) * (uint32_t)n;
+	}
+	return (int)(m >> 32) + 1;
 }
+
+/*
+ * Reduccion de un lote de enteros de 32 bits al rango [1, n]. Los elementos
+ * que caen en la zona de rechazo de Lemire se marcan con 0 y se devuelve
+ * cuantos hubo (casi siempre ninguno: la probabilidad es menor que n / 2^32).
+ */
+static size_t reducir_escalar(uint32_t *lote, size_t cantidad, uint32_t n, uint32_t umbral){
+	size_t rechazos = 0;
+
+	for (size_t k = 0; k < cantidad; k++) {
+		uint64_t m = (uint64_t)lote[k] * n;
+		int rechazo = (uint32_t)m < umbral;
+		lote[k] = rechazo ? 0 : (uint32_t)(m >> 32) + 1;
+		rechazos += rechazo;
+	}
+	return rechazos;
+}
+
+#ifdef DADO_SIMD
+
+__attribute__((target("avx2")))
+static size_t reducir_avx2(uint32_t *lote, size_t cantidad, uint32_t n, uint32_t umbral){
+	const __m256i vn = _mm256_set1_epi32((int)n);
+	const __m256i vumbral = _mm256_set1_epi32((int)umbral);
+	const __m256i uno = _mm256_set1_epi32(1);
+	__m256i rechazos = _mm256_setzero_si256();
+	size_t k = 0;
+
+	for (; k + 8 <= cantidad; k += 8) {
+		__m256i x = _mm256_loadu_si256((const __m256i *)(lote + k));
+		__m256i pares = _mm256_mul_epu32(x, vn);
+		__m256i impares = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), vn);
+		__m256i alto = _mm256_blend_epi32(_mm256_srli_epi64(pares, 32), impares, 0xAA);
+		__m256i bajo = _mm256_blend_epi32(pares, _mm256_slli_epi64(impares, 32), 0xAA);
+		__m256i acepta = _mm256_cmpeq_epi32(_mm256_max_epu32(bajo, vumbral), bajo);
+		__m256i cara = _mm256_and_si256(acepta, _mm256_add_epi32(alto, uno));
+		rechazos = _mm256_add_epi32(rechazos, _mm256_andnot_si256(acepta, uno));
+		_mm256_storeu_si256((__m256i *)(lote + k), cara);
+	}
+
+	uint32_t parcial[8];
+	size_t total = 0;
+	_mm256_storeu_si256((__m256i *)parcial, rechazos);
+	for (int j = 0; j < 8; j++)
+		total += parcial[j];
+	return total + reducir_escalar(lote + k, cantidad - k, n, umbral);
+}
+
+__attribute__((target("avx512f")))
+static size_t reducir_avx512(uint32_t *lote, size_t cantidad, uint32_t n, uint32_t umbral){
+	const __m512i vn = _mm512_set1_epi32((int)n);
+	const __m512i vumbral = _mm512_set1_epi32((int)umbral);
+	const __m512i uno = _mm512_set1_epi32(1);
+	size_t total = 0, k = 0;
+
+	for (; k + 16 <= cantidad; k += 16) {
+		__m512i x = _mm512_loadu_si512(lote + k);
+		__m512i pares = _mm512_mul_epu32(x, vn);
+		__m512i impares = _mm512_mul_epu32(_mm512_srli_epi64(x, 32), vn);
+		__m512i alto = _mm512_mask_blend_epi32(0xAAAA, _mm512_srli_epi64(pares, 32), impares);
+		__m512i bajo = _mm512_mask_blend_epi32(0xAAAA, pares, _mm512_slli_epi64(impares, 32));
+		__mmask16 acepta = _mm512_cmpge_epu32_mask(bajo, vumbral);
+		_mm512_storeu_si512(lote + k, _mm512_maskz_add_epi32(acepta, alto, uno));
+		total += 16 - __builtin_popcount(acepta);
+	}
+	return total + reducir_escalar(lote + k, cantidad - k, n, umbral);
+}
+
+#endif
+
+/*
+ * Llena lote[0..cantidad) con tiros de un dado de n caras. Se generan primero
+ * los enteros crudos y despues se reducen todos juntos, con AVX-512 o AVX2 si
+ * el procesador los tiene.
+ */
+void lanzamientos(Generador *g, int n, uint32_t *lote, size_t cantidad){
+	uint32_t umbral = -(uint32_t)n % (uint32_t)n;
+	size_t k = 0, rechazos;
+
+	for (; k + 2 <= cantidad; k += 2) {
+		uint64_t r = generador_u64(g);
+		lote[k] = (uint32_t)r;
+		lote[k + 1] = (uint32_t)(r >> 32);
+	}
+	if (k < cantidad)
+		lote[k] = (uint32_t)generador_u64(g);
+
+#ifdef DADO_SIMD
+	if (__builtin_cpu_supports("avx512f"))
+		rechazos = reducir_avx512(lote, cantidad, (uint32_t)n, umbral);
+	else if (__builtin_cpu_supports("avx2"))
+		rechazos = reducir_avx2(lote, cantidad, (uint32_t)n, umbral);
+	else
+#endif
+		rechazos = reducir_escalar(lote, cantidad, (uint32_t)n, umbral);
+
+	for (k = 0; rechazos > 0; k++)
+		if (lote[k] == 0) {
+			lote[k] = (uint32_t)lanzamiento(g, n);
+			rechazos--;
+		}
+}
+
+#endif
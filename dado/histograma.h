@@ -0,0 +1,251 @@
+#ifndef HISTOGRAMA_H
+#define HISTOGRAMA_H
+
+/*
+ * Histograma de caras con contadores de 64 bits.
+ *
+ * Hasta UMBRAL_DENSO caras se usa un arreglo denso. Con mas caras se empieza
+ * con una tabla hash de direccionamiento abierto que solo guarda las caras
+ * que han salido; si la tabla llega a ocupar mas que el arreglo denso se
+ * convierte en uno. Asi la memoria queda acotada por min(caras vistas, n).
+ *
+ * Cada histograma vive en sus propias lineas de cache para que los hilos
+ * puedan contar en paralelo sin compartirlas.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define LINEA_CACHE 64
+#define UMBRAL_DENSO (1 << 20)
+#define CAPACIDAD_INICIAL 1024
+
+typedef struct {
+	_Alignas(LINEA_CACHE) uint32_t n;
+	int denso;
+	uint64_t *cuentas;      // denso: cuentas[cara - 1]
+	uint32_t *claves;       // disperso: cara, 0 = casilla libre
+	uint64_t *valores;
+	size_t capacidad, ocupadas;
+	uint64_t total;
+} Histograma;
+
+static void *reservar_alineado(size_t bytes){
+	bytes = (bytes + LINEA_CACHE - 1) / LINEA_CACHE * LINEA_CACHE;
+	return aligned_alloc(LINEA_CACHE, bytes ? bytes : LINEA_CACHE);
+}
+
+static inline size_t ranura(uint32_t cara, size_t capacidad){
+	return (size_t)(cara * 0x9E3779B1u) & (capacidad - 1);
+}
+
+static int histograma_hacer_denso(Histograma *h){
+	uint64_t *cuentas = reservar_alineado((size_t)h->n * sizeof(uint64_t));
+	if (cuentas == NULL)
+		return -1;
+	memset(cuentas, 0, (size_t)h->n * sizeof(uint64_t));
+
+	for (size_t k = 0; k < h->capacidad; k++)
+		if (h->claves[k])
+			cuentas[h->claves[k] - 1] = h->valores[k];
+
+	free(h->claves);
+	free(h->valores);
+	h->claves = NULL;
+	h->valores = NULL;
+	h->capacidad = h->ocupadas = 0;
+	h->cuentas = cuentas;
+	h->denso = 1;
+	return 0;
+}
+
+static int histograma_crecer(Histograma *h){
+	size_t capacidad = h->capacidad * 2;
+
+	if (capacidad * (sizeof(uint32_t) + sizeof(uint64_t)) >= (size_t)h->n * sizeof(uint64_t))
+		return histograma_hacer_denso(h);
+
+	uint32_t *claves = reservar_alineado(capacidad * sizeof(uint32_t));
+	uint64_t *valores = reservar_alineado(capacidad * sizeof(uint64_t));
+	if (claves == NULL || valores == NULL) {
+		free(claves);
+		free(valores);
+		return -1;
+	}
+	memset(claves, 0, capacidad * sizeof(uint32_t));
+
+	for (size_t k = 0; k < h->capacidad; k++) {
+		if (h->claves[k] == 0)
+			continue;
+		size_t r = ranura(h->claves[k], capacidad);
+		while (claves[r])
+			r = (r + 1) & (capacidad - 1);
+		claves[r] = h->claves[k];
+		valores[r] = h->valores[k];
+	}
+
+	free(h->claves);
+	free(h->valores);
+	h->claves = claves;
+	h->valores = valores;
+	h->capacidad = capacidad;
+	return 0;
+}
+
+/*
+ * Reserva un histograma de n caras alineado a linea de cache. Devuelve NULL
+ * si no hay memoria.
+ */
+Histograma *histograma_crear(uint32_t n){
+	Histograma *h = reservar_alineado(sizeof(Histograma));
+	if (h == NULL)
+		return NULL;
+	memset(h, 0, sizeof(Histograma));
+	h->n = n;
+
+	if (n <= UMBRAL_DENSO) {
+		h->denso = 1;
+		h->cuentas = reservar_alineado((size_t)n * sizeof(uint64_t));
+		if (h->cuentas != NULL)
+			memset(h->cuentas, 0, (size_t)n * sizeof(uint64_t));
+	} else {
+		h->capacidad = CAPACIDAD_INICIAL;
+		h->claves = reservar_alineado(h->capacidad * sizeof(uint32_t));
+		h->valores = reservar_alineado(h->capacidad * sizeof(uint64_t));
+		if (h->claves != NULL)
+			memset(h->claves, 0, h->capacidad * sizeof(uint32_t));
+	}
+
+	if (h->denso ? h->cuentas == NULL : h->claves == NULL || h->valores == NULL) {
+		free(h->cuentas);
+		free(h->claves);
+		free(h->valores);
+		free(h);
+		return NULL;
+	}
+	return h;
+}
+
+void histograma_destruir(Histograma *h){
+	if (h == NULL)
+		return;
+	free(h->cuentas);
+	free(h->claves);
+	free(h->valores);
+	free(h);
+}
+
+// Suma 'veces' a la cara dada. Devuelve -1 si no hubo memoria para crecer.
+int histograma_sumar(Histograma *h, uint32_t cara, uint64_t veces){
+	h->total += veces;
+	if (h->denso) {
+		h->cuentas[cara - 1] += veces;
+		return 0;
+	}
+
+	size_t r = ranura(cara, h->capacidad);
+	while (h->claves[r] && h->claves[r] != cara)
+		r = (r + 1) & (h->capacidad - 1);
+
+	if (h->claves[r] == 0) {
+		h->claves[r] = cara;
+		h->valores[r] = 0;
+		h->ocupadas++;
+	}
+	h->valores[r] += veces;
+
+	if (2 * h->ocupadas > h->capacidad)
+		return histograma_crecer(h);
+	return 0;
+}
+
+int histograma_sumar_lote(Histograma *h, const uint32_t *lote, size_t cantidad){
+	if (h->denso) {
+		uint64_t *cuentas = h->cuentas - 1;
+		for (size_t k = 0; k < cantidad; k++)
+			cuentas[lote[k]]++;
+		h->total += cantidad;
+		return 0;
+	}
+
+	for (size_t k = 0; k < cantidad; k++)
+		if (histograma_sumar(h, lote[k], 1) != 0)
+			return -1;
+	return 0;
+}
+
+uint64_t histograma_cuenta(const Histograma *h, uint32_t cara){
+	if (h->denso)
+		return h->cuentas[cara - 1];
+
+	size_t r = ranura(cara, h->capacidad);
+	while (h->claves[r]) {
+		if (h->claves[r] == cara)
+			return h->valores[r];
+		r = (r + 1) & (h->capacidad - 1);
+	}
+	return 0;
+}
+
+// Suma todas las cuentas de 'origen' en 'destino'.
+int histograma_fusionar(Histograma *destino, const Histograma *origen){
+	if (origen->denso) {
+		for (uint32_t c = 1; c <= origen->n; c++)
+			if (origen->cuentas[c - 1] && histograma_sumar(destino, c, origen->cuentas[c - 1]) != 0)
+				return -1;
+		return 0;
+	}
+
+	for (size_t k = 0; k < origen->capacidad; k++)
+		if (origen->claves[k] && histograma_sumar(destino, origen->claves[k], origen->valores[k]) != 0)
+			return -1;
+	return 0;
+}
+
+// Deja todas las cuentas en cero sin liberar memoria.
+void histograma_vaciar(Histograma *h){
+	if (h->denso)
+		memset(h->cuentas, 0, (size_t)h->n * sizeof(uint64_t));
+	else
+		memset(h->claves, 0, h->capacidad * sizeof(uint32_t));
+	h->ocupadas = 0;
+	h->total = 0;
+}
+
+static int comparar_caras(const void *a, const void *b){
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+	return (x > y) - (x < y);
+}
+
+/*
+ * Escribe una fila "cara,cuenta" por cara, con la cara recorrida en
+ * 'desplazamiento' (p. ej. la suma minima de k dados). En modo denso salen
+ * todas; en modo disperso solo las que aparecieron, en orden.
+ */
+int histograma_escribir_csv(const Histograma *h, FILE *archivo, long long desplazamiento){
+	if (h->denso) {
+		for (uint32_t c = 1; c <= h->n; c++)
+			fprintf(archivo, "%lld,%llu\n", c + desplazamiento, (unsigned long long)h->cuentas[c - 1]);
+		return 0;
+	}
+
+	uint32_t *caras = malloc((h->ocupadas ? h->ocupadas : 1) * sizeof(uint32_t));
+	if (caras == NULL)
+		return -1;
+
+	size_t m = 0;
+	for (size_t k = 0; k < h->capacidad; k++)
+		if (h->claves[k])
+			caras[m++] = h->claves[k];
+	qsort(caras, m, sizeof(uint32_t), comparar_caras);
+
+	for (size_t k = 0; k < m; k++)
+		fprintf(archivo, "%lld,%llu\n", caras[k] + desplazamiento,
+		        (unsigned long long)histograma_cuenta(h, caras[k]));
+	free(caras);
+	return 0;
+}
+
+#endif
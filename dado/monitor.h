@@ -0,0 +1,211 @@
+#ifndef MONITOR_H
+#define MONITOR_H
+
+/*
+ * Prueba de bondad de ajuste (chi cuadrada) que se actualiza conforme llegan
+ * las cuentas, sin volver a recorrer los tiros.
+ *
+ * Para un dado justo con N tiros y E = N / n:
+ *     chi2 = sum (O_k - E)^2 / E = n * sum O_k^2 / N - N
+ * asi que basta con llevar sum O_k^2, que cambia en 2*O*d + d^2 cuando una
+ * cara pasa de O a O + d. La desviacion relativa maxima sale de la cuenta
+ * mayor y la menor; la mayor se lleva al vuelo y la menor es 0 mientras
+ * falten caras por salir.
+ *
+ * Si cada cara k tiene probabilidad p_k (suma de dados, dado cargado) se
+ * lleva sum O_k^2 / p_k en su lugar. Las caras con p_k < PROBABILIDAD_MINIMA
+ * quedan fuera de la prueba, y la desviacion maxima se busca recorriendo las
+ * caras con al menos 5 tiros esperados.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include "histograma.h"
+
+#define PROBABILIDAD_MINIMA 1e-12
+
+typedef struct {
+	uint32_t n;
+	uint64_t total;
+	unsigned __int128 suma_cuadrados;
+	const double *probabilidad;     // NULL para un dado justo
+	long double suma_ponderada;     // sum O_k^2 / p_k
+	long double probabilidad_incluida;
+	uint64_t total_incluido;
+	uint32_t categorias;
+	uint64_t maximo;
+	uint32_t caras_vistas;
+} Monitor;
+
+typedef struct {
+	uint64_t tiros;
+	double chi2;
+	double valor_p;
+	double desviacion;   // max |O_k - E| / E
+} Reporte;
+
+// 'probabilidad' puede ser NULL (dado justo); si no, debe vivir lo que el monitor.
+void monitor_iniciar(Monitor *m, uint32_t n, const double *probabilidad){
+	m->n = n;
+	m->total = 0;
+	m->suma_cuadrados = 0;
+	m->probabilidad = probabilidad;
+	m->suma_ponderada = 0;
+	m->probabilidad_incluida = 0;
+	m->total_incluido = 0;
+	m->categorias = n;
+	m->maximo = 0;
+	m->caras_vistas = 0;
+
+	if (probabilidad != NULL) {
+		m->categorias = 0;
+		for (uint32_t c = 0; c < n; c++)
+			if (probabilidad[c] >= PROBABILIDAD_MINIMA) {
+				m->probabilidad_incluida += probabilidad[c];
+				m->categorias++;
+			}
+	}
+}
+
+// Registra que una cara paso de 'anterior' a 'anterior + delta' tiros.
+static inline void monitor_acumular(Monitor *m, uint32_t cara, uint64_t anterior, uint64_t delta){
+	uint64_t nuevo = anterior + delta;
+
+	if (m->probabilidad == NULL)
+		m->suma_cuadrados += (unsigned __int128)delta * (2 * anterior + delta);
+	else if (m->probabilidad[cara - 1] >= PROBABILIDAD_MINIMA) {
+		m->suma_ponderada += (long double)delta * (2 * anterior + delta) / m->probabilidad[cara - 1];
+		m->total_incluido += delta;
+	}
+	m->total += delta;
+	m->caras_vistas += anterior == 0;
+	if (nuevo > m->maximo)
+		m->maximo = nuevo;
+}
+
+/*
+ * Suma las cuentas de 'ronda' en 'global' actualizando el monitor y deja
+ * 'ronda' en cero para la siguiente.
+ */
+int monitor_fusionar(Monitor *m, Histograma *global, Histograma *ronda){
+	if (ronda->denso) {
+		for (uint32_t c = 1; c <= ronda->n; c++) {
+			uint64_t delta = ronda->cuentas[c - 1];
+			if (delta == 0)
+				continue;
+			monitor_acumular(m, c, histograma_cuenta(global, c), delta);
+			if (histograma_sumar(global, c, delta) != 0)
+				return -1;
+		}
+	} else {
+		for (size_t k = 0; k < ronda->capacidad; k++) {
+			if (ronda->claves[k] == 0)
+				continue;
+			monitor_acumular(m, ronda->claves[k], histograma_cuenta(global, ronda->claves[k]),
+			                 ronda->valores[k]);
+			if (histograma_sumar(global, ronda->claves[k], ronda->valores[k]) != 0)
+				return -1;
+		}
+	}
+	histograma_vaciar(ronda);
+	return 0;
+}
+
+/*
+ * Probabilidad de que una chi cuadrada con 'grados' grados de libertad supere
+ * x, es decir Q(grados/2, x/2). Serie o fraccion continua segun convenga; con
+ * muchos grados de libertad se usa la aproximacion de Wilson-Hilferty.
+ */
+double chi2_cola(double x, double grados){
+	if (x <= 0)
+		return 1.0;
+	if (grados > 1e5) {
+		double v = 2.0 / (9.0 * grados);
+		double z = (cbrt(x / grados) - (1.0 - v)) / sqrt(v);
+		return 0.5 * erfc(z / sqrt(2.0));
+	}
+
+	double a = grados / 2, y = x / 2;
+	double ln_prefijo = a * log(y) - y - lgamma(a);
+
+	if (y < a + 1) {
+		double termino = 1.0 / a, suma = termino;
+		for (int k = 1; k < 100000 && fabs(termino) > fabs(suma) * 1e-15; k++) {
+			termino *= y / (a + k);
+			suma += termino;
+		}
+		return 1.0 - suma * exp(ln_prefijo);
+	}
+
+	// Fraccion continua de Lentz
+	double b = y + 1 - a, c = 1.0 / 1e-300, d = 1.0 / b, h = d;
+	for (int k = 1; k < 100000; k++) {
+		double an = -k * (k - a);
+		b += 2;
+		d = an * d + b;
+		if (fabs(d) < 1e-300) d = 1e-300;
+		c = b + an / c;
+		if (fabs(c) < 1e-300) c = 1e-300;
+		d = 1.0 / d;
+		double delta = d * c;
+		h *= delta;
+		if (fabs(delta - 1.0) < 1e-15)
+			break;
+	}
+	return exp(ln_prefijo) * h;
+}
+
+// Cuantil z de la normal estandar tal que P(|Z| < z) = confianza.
+double z_confianza(double confianza){
+	double bajo = 0, alto = 40;
+	for (int k = 0; k < 100; k++) {
+		double medio = (bajo + alto) / 2;
+		if (erf(medio / sqrt(2.0)) < confianza)
+			bajo = medio;
+		else
+			alto = medio;
+	}
+	return (bajo + alto) / 2;
+}
+
+Reporte monitor_reporte(const Monitor *m, const Histograma *global){
+	Reporte r = {m->total, 0, 1, 0};
+	if (m->total == 0)
+		return r;
+
+	if (m->probabilidad != NULL) {
+		long double total = m->total;
+		r.chi2 = (double)(m->suma_ponderada / total - 2 * (long double)m->total_incluido
+		                  + total * m->probabilidad_incluida);
+		r.valor_p = m->categorias > 1 ? chi2_cola(r.chi2, m->categorias - 1) : 1.0;
+
+		for (uint32_t c = 1; c <= m->n; c++) {
+			double esperado = m->total * m->probabilidad[c - 1];
+			if (esperado < 5)
+				continue;
+			double desviacion = fabs(histograma_cuenta(global, c) - esperado) / esperado;
+			if (desviacion > r.desviacion)
+				r.desviacion = desviacion;
+		}
+		return r;
+	}
+
+	long double esperado = (long double)m->total / m->n;
+	r.chi2 = (double)((long double)m->suma_cuadrados / esperado - m->total);
+	r.valor_p = m->n > 1 ? chi2_cola(r.chi2, m->n - 1) : 1.0;
+
+	// Cuenta minima: 0 mientras falte alguna cara; si no, hay que buscarla
+	uint64_t minimo = 0;
+	if (m->caras_vistas == m->n && global->denso) {
+		minimo = UINT64_MAX;
+		for (uint32_t c = 0; c < global->n; c++)
+			if (global->cuentas[c] < minimo)
+				minimo = global->cuentas[c];
+	}
+
+	long double arriba = m->maximo - esperado, abajo = esperado - minimo;
+	r.desviacion = (double)((arriba > abajo ? arriba : abajo) / esperado);
+	return r;
+}
+
+#endif
@@ -1,27 +1,378 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
+#include <pthread.h>
 #include "dado.h"
+#include "histograma.h"
+#include "monitor.h"
+#include "suma.h"
+#include "alias.h"
+#include "../comun/grafica.h"
 
-int main() {
-    int n, i;
-    FILE *archivo;
+// Alineada a linea de cache para que el estado de un hilo no comparta linea con otro.
+typedef struct {
+    _Alignas(LINEA_CACHE) Generador generador;
+    int n, k;
+    const TablaAlias *cargado;   // NULL para un dado justo
+    long long tiros;
+    Histograma *conteo;
+    int error;
+} Tarea;
 
-    // 1. Solicitar parámetros al usuario
-    printf("Introduce el número de caras del dado (n): ");
-    scanf("%d", &n);
+#define TAM_LOTE 4096
+
+static void tirar(Tarea *tarea, uint32_t *lote, size_t cantidad) {
+    if (tarea->cargado != NULL)
+        lanzamientos_alias(&tarea->generador, tarea->cargado, lote, cantidad);
+    else
+        lanzamientos(&tarea->generador, tarea->n, lote, cantidad);
+}
+
+// Cada tiro es la suma de k dados; se cuenta en la casilla suma - k + 1.
+static void simular_suma(Tarea *tarea) {
+    uint32_t lote[TAM_LOTE], sumas[TAM_LOTE];
+    size_t usados = TAM_LOTE, m = 0;
+
+    for (long long j = 0; j < tarea->tiros; j++) {
+        uint32_t suma = 0;
+        for (int faltan = tarea->k; faltan > 0; ) {
+            if (usados == TAM_LOTE) {
+                tirar(tarea, lote, TAM_LOTE);
+                usados = 0;
+            }
+            size_t tomar = TAM_LOTE - usados < (size_t)faltan ? TAM_LOTE - usados : (size_t)faltan;
+            for (size_t d = 0; d < tomar; d++)
+                suma += lote[usados + d];
+            usados += tomar;
+            faltan -= tomar;
+        }
+        sumas[m++] = suma - tarea->k + 1;
+
+        if (m == TAM_LOTE || j + 1 == tarea->tiros) {
+            if (histograma_sumar_lote(tarea->conteo, sumas, m) != 0) {
+                tarea->error = 1;
+                return;
+            }
+            m = 0;
+        }
+    }
+}
+
+// Cada hilo tira con su propio flujo y cuenta en su propio histograma.
+void *simular(void *arg) {
+    Tarea *tarea = arg;
+    uint32_t lote[TAM_LOTE];
+
+    if (tarea->k > 1) {
+        simular_suma(tarea);
+        return NULL;
+    }
+
+    for (long long j = 0; j < tarea->tiros; j += TAM_LOTE) {
+        size_t cantidad = tarea->tiros - j < TAM_LOTE ? tarea->tiros - j : TAM_LOTE;
+        tirar(tarea, lote, cantidad);
+        if (histograma_sumar_lote(tarea->conteo, lote, cantidad) != 0) {
+            tarea->error = 1;
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+static double cuenta_casilla(size_t i, const void *histograma) {
+    return (double)histograma_cuenta(histograma, (uint32_t)i + 1);
+}
+
+/*
+ * Modo barrido: una lista de configuraciones (caras, tiros, semilla) se
+ * reparte entre un grupo de hilos; cada configuracion corre completa en un
+ * solo hilo con el flujo 0 de su semilla, asi que su resultado no depende de
+ * cuantos hilos haya. Todo se agrega a un solo CSV en formato largo.
+ */
+typedef struct {
+    int caras;
+    long long tiros;
+    unsigned long long semilla;
+} Configuracion;
+
+typedef struct {
+    const Configuracion *configuraciones;
+    int total, siguiente, k, error;
+    FILE *salida;
+    pthread_mutex_t candado;
+} Barrido;
+
+static int agregar_configuracion(Configuracion **lista, int *total, int *capacidad,
+                                 int caras, long long tiros, unsigned long long semilla) {
+    if (caras <= 0 || tiros <= 0)
+        return -1;
+    if (*total == *capacidad) {
+        int nueva = *capacidad ? 2 * *capacidad : 64;
+        Configuracion *mas = realloc(*lista, nueva * sizeof(Configuracion));
+        if (mas == NULL)
+            return -1;
+        *lista = mas;
+        *capacidad = nueva;
+    }
+    (*lista)[(*total)++] = (Configuracion){caras, tiros, semilla};
+    return 0;
+}
+
+// Renglones "caras,tiros,semilla"; los vacios o que empiezan con # se ignoran.
+static int leer_configuraciones(const char *nombre, Configuracion **lista, int *total, int *capacidad) {
+    FILE *archivo = fopen(nombre, "r");
+    char linea[256];
+    int caras;
+    long long tiros;
+    unsigned long long semilla;
+
+    if (archivo == NULL)
+        return -1;
+    while (fgets(linea, sizeof(linea), archivo)) {
+        if (linea[0] == '#' || sscanf(linea, "%d , %lld , %llu", &caras, &tiros, &semilla) != 3)
+            continue;
+        if (agregar_configuracion(lista, total, capacidad, caras, tiros, semilla) != 0) {
+            fclose(archivo);
+            return -1;
+        }
+    }
+    fclose(archivo);
+    return 0;
+}
+
+/*
+ * Rejilla en la linea de comandos: "caras:tiros:semillas", cada parte una
+ * lista separada por comas; se toma el producto cartesiano.
+ * Ejemplo: 6,20:1000000,10000000:1,2,3 son 12 configuraciones.
+ */
+static int expandir_rejilla(const char *texto, Configuracion **lista, int *total, int *capacidad) {
+    char copia[1024], *partes[3], *resto;
+    long long valores[3][64];
+    int cuantos[3] = {0, 0, 0};
+
+    if (strlen(texto) >= sizeof(copia))
+        return -1;
+    strcpy(copia, texto);
+    partes[0] = strtok_r(copia, ":", &resto);
+    partes[1] = strtok_r(NULL, ":", &resto);
+    partes[2] = strtok_r(NULL, ":", &resto);
+    if (partes[2] == NULL)
+        return -1;
+
+    for (int p = 0; p < 3; p++) {
+        char *valor, *resto_valor;
+        for (valor = strtok_r(partes[p], ",", &resto_valor); valor != NULL && cuantos[p] < 64;
+             valor = strtok_r(NULL, ",", &resto_valor))
+            valores[p][cuantos[p]++] = (long long)strtod(valor, NULL);
+    }
+
+    for (int a = 0; a < cuantos[0]; a++)
+        for (int b = 0; b < cuantos[1]; b++)
+            for (int c = 0; c < cuantos[2]; c++)
+                if (agregar_configuracion(lista, total, capacidad, (int)valores[0][a],
+                                          valores[1][b], (unsigned long long)valores[2][c]) != 0)
+                    return -1;
+    return 0;
+}
+
+static int correr_configuracion(const Configuracion *config, int k, FILE *salida, pthread_mutex_t *candado) {
+    uint32_t casillas = (uint32_t)k * (config->caras - 1) + 1;
+    size_t largo;
+    double *exacta = k > 1 ? suma_exacta(NULL, config->caras, k, &largo) : NULL;
+    Histograma *conteo = histograma_crear(casillas), *global = histograma_crear(casillas);
+    Tarea tarea = {.n = config->caras, .k = k, .cargado = NULL, .tiros = config->tiros,
+                   .conteo = conteo, .error = 0};
+    Monitor monitor;
+    int error = conteo == NULL || global == NULL || (k > 1 && exacta == NULL);
+
+    if (!error) {
+        generador_iniciar(&tarea.generador, config->semilla, 0);
+        simular(&tarea);
+        monitor_iniciar(&monitor, casillas, exacta);
+        error = tarea.error || monitor_fusionar(&monitor, global, conteo) != 0;
+    }
+
+    if (!error) {
+        Reporte reporte = monitor_reporte(&monitor, global);
+        pthread_mutex_lock(candado);
+        for (uint32_t c = 1; c <= casillas; c++) {
+            uint64_t cuenta = histograma_cuenta(global, c);
+            if (cuenta > 0 || global->denso)
+                fprintf(salida, "%d,%d,%lld,%llu,%u,%llu,%.6f,%.6f\n", config->caras, k, config->tiros,
+                        config->semilla, c + k - 1, (unsigned long long)cuenta,
+                        reporte.chi2, reporte.valor_p);
+        }
+        pthread_mutex_unlock(candado);
+    }
+
+    histograma_destruir(conteo);
+    histograma_destruir(global);
+    free(exacta);
+    return error ? -1 : 0;
+}
+
+void *trabajar_barrido(void *arg) {
+    Barrido *barrido = arg;
+
+    for (;;) {
+        pthread_mutex_lock(&barrido->candado);
+        int j = barrido->siguiente++;
+        pthread_mutex_unlock(&barrido->candado);
+        if (j >= barrido->total)
+            break;
+        if (correr_configuracion(&barrido->configuraciones[j], barrido->k,
+                                 barrido->salida, &barrido->candado) != 0)
+            barrido->error = 1;
+    }
+    return NULL;
+}
+
+static int barrer(const Configuracion *configuraciones, int total, int k, int hilos) {
+    Barrido barrido = {configuraciones, total, 0, k, 0, NULL, PTHREAD_MUTEX_INITIALIZER};
+    pthread_t *ids = malloc(hilos * sizeof(pthread_t));
+
+    barrido.salida = fopen("barrido_dados.csv", "a");
+    if (ids == NULL || barrido.salida == NULL) {
+        printf("Error al abrir el archivo.\n");
+        free(ids);
+        return 1;
+    }
+    fseek(barrido.salida, 0, SEEK_END);
+    if (ftell(barrido.salida) == 0)
+        fprintf(barrido.salida, "Caras,Dados,Tiros,Semilla,Cara,Frecuencia,ChiCuadrada,ValorP\n");
+
+    printf("Corriendo %d configuraciones en %d hilos...\n", total, hilos);
+    for (int h = 0; h < hilos; h++)
+        pthread_create(&ids[h], NULL, trabajar_barrido, &barrido);
+    for (int h = 0; h < hilos; h++)
+        pthread_join(ids[h], NULL);
+
+    fclose(barrido.salida);
+    free(ids);
+    if (barrido.error) {
+        printf("Error: memoria insuficiente en alguna configuración.\n");
+        return 1;
+    }
+    printf("Resultados agregados a 'barrido_dados.csv'.\n");
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int n, k = 1, hilos = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    long long i, intervalo = 0;
+    double confianza = 0, tolerancia = 0;
+    unsigned long long semilla = (unsigned long long)time(NULL);
+    FILE *archivo, *bitacora = NULL;
+    const char *pesos = NULL;
+    TablaAlias tabla;
+    Configuracion *configuraciones = NULL;
+    int total_configuraciones = 0, capacidad_configuraciones = 0;
+    int opcion;
+
+    // 0. Opciones: -s semilla (para repetir una corrida), -t numero de hilos,
+    //    -m tiros entre reportes, -c confianza para detenerse antes,
+    //    -e error relativo buscado por cara (junto con -c),
+    //    -k numero de dados que se suman en cada tiro,
+    //    -w archivo con un peso por cara para un dado cargado,
+    //    -b archivo / -g rejilla: modo barrido sin preguntas ni grafica
+    while ((opcion = getopt(argc, argv, "s:t:m:c:e:k:w:b:g:")) != -1) {
+        switch (opcion) {
+        case 's': semilla = strtoull(optarg, NULL, 10); break;
+        case 't': hilos = atoi(optarg); break;
+        case 'm': intervalo = atoll(optarg); break;
+        case 'c': confianza = atof(optarg); break;
+        case 'e': tolerancia = atof(optarg); break;
+        case 'k': k = atoi(optarg); break;
+        case 'w': pesos = optarg; break;
+        case 'b':
+            if (leer_configuraciones(optarg, &configuraciones, &total_configuraciones,
+                                     &capacidad_configuraciones) != 0) {
+                printf("Error: No se pudo leer el barrido de '%s'.\n", optarg);
+                return 1;
+            }
+            break;
+        case 'g':
+            if (expandir_rejilla(optarg, &configuraciones, &total_configuraciones,
+                                 &capacidad_configuraciones) != 0) {
+                printf("Error: Rejilla inválida '%s' (se espera caras:tiros:semillas).\n", optarg);
+                return 1;
+            }
+            break;
+        default:
+            fprintf(stderr, "Uso: %s [-s semilla] [-t hilos] [-m tiros_por_reporte]"
+                            " [-c confianza] [-e error_relativo] [-k dados]"
+                            " [-w archivo_pesos] [-b archivo_barrido] [-g caras:tiros:semillas]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (hilos < 1)
+        hilos = 1;
+    if (confianza < 0 || confianza >= 1) {
+        printf("Error: La confianza debe estar en [0, 1).\n");
+        return 1;
+    }
+    if (k <= 0) {
+        printf("Error: Los parámetros deben ser mayores a 0.\n");
+        return 1;
+    }
+
+    if (total_configuraciones > 0) {
+        int resultado = barrer(configuraciones, total_configuraciones, k, hilos);
+        free(configuraciones);
+        return resultado;
+    }
+
+    // 1. Solicitar parámetros al usuario; con -w las caras salen del archivo
+    if (pesos != NULL) {
+        if (alias_cargar(&tabla, pesos) != 0 || tabla.n > INT32_MAX) {
+            printf("Error: No se pudieron leer los pesos de '%s'.\n", pesos);
+            return 1;
+        }
+        n = (int)tabla.n;
+        printf("Dado cargado de %d caras leído de '%s'.\n", n, pesos);
+    } else {
+        printf("Introduce el número de caras del dado (n): ");
+        scanf("%d", &n);
+    }
     printf("Introduce el número de veces a tirar el dado (i): ");
-    scanf("%d", &i);
-    
-    int resultados[n];
-    
-    for (int j = 0; j < n; j++)
-        resultados[j] = 0;
-
-    if (n <= 0 || i <= 0) {
+    scanf("%lld", &i);
+
+    if (n <= 0 || i <= 0 || k <= 0) {
         printf("Error: Los parámetros deben ser mayores a 0.\n");
         return 1;
     }
+    if ((long long)k * n > UINT32_MAX) {
+        printf("Error: La suma de %d dados de %d caras no cabe en 32 bits.\n", k, n);
+        return 1;
+    }
+    if (intervalo <= 0 || intervalo > i)
+        intervalo = i;
+
+    // Con k dados el histograma va de la suma k (casilla 1) a la suma k*n
+    uint32_t casillas = (uint32_t)k * (n - 1) + 1;
+    double *exacta = NULL;
+
+    if (k > 1) {
+        size_t largo;
+        clock_t inicio = clock();
+        exacta = suma_exacta(pesos != NULL ? tabla.probabilidad : NULL, n, k, &largo);
+        if (exacta == NULL) {
+            printf("Error: memoria insuficiente.\n");
+            return 1;
+        }
+        printf("Distribución exacta de la suma de %d dados calculada en %.3f ms.\n",
+               k, 1000.0 * (clock() - inicio) / CLOCKS_PER_SEC);
+    }
+
+    Histograma *resultados = histograma_crear(casillas);
+    if (resultados == NULL) {
+        printf("Error: memoria insuficiente.\n");
+        return 1;
+    }
 
     // 2. Abrir (o crear) el archivo CSV para escritura
     archivo = fopen("resultados_dados.csv", "w");
@@ -33,28 +384,139 @@ int main() {
     // Escribir el encabezado del CSV
     fprintf(archivo, "Tiro,Resultado\n");
 
-    // 3. Inicializar la semilla para números aleatorios
-    srand(time(NULL));
+    if (intervalo < i) {
+        bitacora = fopen("monitor_dados.csv", "w");
+        if (bitacora == NULL) {
+            printf("Error al abrir el archivo.\n");
+            return 1;
+        }
+        fprintf(bitacora, "Tiros,ChiCuadrada,ValorP,DesviacionMaxima\n");
+    }
+
+    // 3. Un flujo independiente del generador por hilo, todos con la misma semilla
+    Tarea *tareas = aligned_alloc(LINEA_CACHE, hilos * sizeof(Tarea));
+    pthread_t *ids = malloc(hilos * sizeof(pthread_t));
+    if (tareas == NULL || ids == NULL) {
+        printf("Error: memoria insuficiente.\n");
+        return 1;
+    }
+
+    for (int h = 0; h < hilos; h++) {
+        generador_iniciar(&tareas[h].generador, semilla, h);
+        tareas[h].n = n;
+        tareas[h].k = k;
+        tareas[h].cargado = pesos != NULL ? &tabla : NULL;
+        tareas[h].conteo = histograma_crear(casillas);
+        tareas[h].error = 0;
+        if (tareas[h].conteo == NULL) {
+            printf("Error: memoria insuficiente.\n");
+            return 1;
+        }
+    }
+
+    // 4. Simular los tiros por rondas de 'intervalo' tiros. Al final de cada
+    //    ronda los histogramas privados se juntan en el global y el monitor
+    //    se actualiza solo con lo que cambio.
+    printf("\nSimulando %lld tiros de %d dado(s) de %d caras en %d hilos (semilla %llu)...\n",
+           i, k, n, hilos, semilla);
+
+    Monitor monitor;
+    Reporte reporte = {0, 0, 1, 0};
+    double z = confianza > 0 ? z_confianza(confianza) : 0;
+    long long hechos = 0;
+    int error = 0;
 
-    // 4. Simular los tiros y guardar en el archivo
-    printf("\nSimulando %d tiros de un dado de %d caras...\n", i, n);
-    
-    for (int j = 1; j <= i; j++) {
-        // Generar número entre 1 y n
-        int resultado = lanzamiento(n);
-        resultados[resultado-1]++;
+    monitor_iniciar(&monitor, casillas, k > 1 ? exacta : pesos != NULL ? tabla.probabilidad : NULL);
+    while (hechos < i && !error) {
+        long long ronda = i - hechos < intervalo ? i - hechos : intervalo;
+
+        for (int h = 0; h < hilos; h++) {
+            tareas[h].tiros = ronda / hilos + (h < ronda % hilos);
+            pthread_create(&ids[h], NULL, simular, &tareas[h]);
+        }
+        for (int h = 0; h < hilos; h++) {
+            pthread_join(ids[h], NULL);
+            error |= tareas[h].error || monitor_fusionar(&monitor, resultados, tareas[h].conteo) != 0;
+        }
+        hechos += ronda;
+
+        reporte = monitor_reporte(&monitor, resultados);
+        if (bitacora == NULL)
+            continue;
+
+        printf("Tiros: %lld  chi2 = %.4f  p = %.4f  desviación máxima = %.4f%%\n",
+               hechos, reporte.chi2, reporte.valor_p, 100 * reporte.desviacion);
+        fprintf(bitacora, "%lld,%.6f,%.6f,%.6f\n",
+                hechos, reporte.chi2, reporte.valor_p, reporte.desviacion);
+        fflush(bitacora);
+
+        // Con -c se para en cuanto el dado se rechaza como justo a esa
+        // confianza, o (con -e) cuando el intervalo de confianza de cada
+        // cara ya es mas angosto que el error relativo pedido.
+        if (confianza > 0 && hechos < i) {
+            if (reporte.valor_p < 1 - confianza) {
+                printf("El dado no es justo con %.2f%% de confianza; se detiene la simulación.\n",
+                       100 * confianza);
+                break;
+            }
+            if (tolerancia > 0 && z * sqrt((double)(monitor.categorias - 1) / hechos) <= tolerancia) {
+                printf("Precisión de %.4f%% alcanzada con %.2f%% de confianza; se detiene la simulación.\n",
+                       100 * tolerancia, 100 * confianza);
+                break;
+            }
+        }
+    }
+
+    for (int h = 0; h < hilos; h++)
+        histograma_destruir(tareas[h].conteo);
+    free(tareas);
+    free(ids);
+    if (bitacora != NULL)
+        fclose(bitacora);
+
+    printf("\nResultado con %lld tiros: chi2 = %.4f con %u grados de libertad, p = %.4f\n",
+           hechos, reporte.chi2, monitor.categorias - 1, reporte.valor_p);
+
+    if (error || histograma_escribir_csv(resultados, archivo, k - 1) != 0) {
+        printf("Error: memoria insuficiente.\n");
+        return 1;
     }
-    
-    for (int j = 0; j < n; j++)
-        fprintf(archivo, "%d,%d\n", j+1, resultados[j]);
 
-    // 5. Cerrar el archivo y finalizar
+    // Con k dados tambien se escribe la frecuencia esperada exacta, con la
+    // misma forma que resultados_dados.csv, y la distancia L1 entre ambas
+    if (exacta != NULL) {
+        FILE *esperado = fopen("exacta_dados.csv", "w");
+        if (esperado == NULL) {
+            printf("Error al abrir el archivo.\n");
+            return 1;
+        }
+        fprintf(esperado, "Tiro,Resultado\n");
+
+        double l1 = 0;
+        for (uint32_t c = 1; c <= casillas; c++) {
+            double empirica = (double)histograma_cuenta(resultados, c) / hechos;
+            l1 += fabs(empirica - exacta[c - 1]);
+            fprintf(esperado, "%u,%.6f\n", c + k - 1, exacta[c - 1] * hechos);
+        }
+        fclose(esperado);
+        printf("Distancia L1 entre la simulación y la distribución exacta: %.6f\n", l1);
+        free(exacta);
+    }
+    // 5. Cerrar el archivo y graficar directamente desde las cuentas
     fclose(archivo);
-    printf("\nCSV generado. Iniciando script de Python para graficar...\n");
+    printf("\nCSV generado.\n");
+
+    if (grafica_barras("grafica_resultados.svg",
+                       k > 1 ? "Frecuencia de la Suma de los Dados" : "Frecuencia de Resultados del Dado",
+                       k > 1 ? "Suma de los dados" : "Cara del Dado", "Cantidad de veces",
+                       casillas, k, cuenta_casilla, resultados) != 0)
+        printf("Error al graficar.\n");
+    else
+        printf("Gráfica guardada como 'grafica_resultados.svg'\n");
 
-    // Ejecución de comando bash desde C
-    // Asegúrate de usar 'python' o 'python3' según tu sistema
-    system("python3 grafica.py");
+    histograma_destruir(resultados);
+    if (pesos != NULL)
+        alias_liberar(&tabla);
 
     return 0;
 }
@@ -0,0 +1,106 @@
+#ifndef SUMA_H
+#define SUMA_H
+
+/*
+ * Distribucion exacta de la suma de k dados de n caras, justos o cargados.
+ *
+ * La suma de k dados es la convolucion de k copias de la distribucion de uno
+ * solo, asi que en el dominio de la frecuencia basta con elevar su
+ * transformada a la k (por cuadrados sucesivos) y regresar. Con un tamano de
+ * FFT de al menos k(n - 1) + 1 la convolucion circular no mezcla las colas.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <complex.h>
+#include <math.h>
+
+static int fft(double complex *x, size_t m, int inversa){
+	double complex *giro = malloc((m / 2 + 1) * sizeof(double complex));
+	if (giro == NULL)
+		return -1;
+	for (size_t j = 0; j < m / 2; j++)
+		giro[j] = cexp((inversa ? 2 : -2) * M_PI * I * j / m);
+
+	for (size_t i = 1, j = 0; i < m; i++) {
+		size_t bit = m >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+		if (i < j) {
+			double complex t = x[i];
+			x[i] = x[j];
+			x[j] = t;
+		}
+	}
+
+	for (size_t largo = 2; largo <= m; largo <<= 1) {
+		size_t paso = m / largo;
+		for (size_t i = 0; i < m; i += largo)
+			for (size_t j = 0; j < largo / 2; j++) {
+				double complex u = x[i + j], v = x[i + j + largo / 2] * giro[j * paso];
+				x[i + j] = u + v;
+				x[i + j + largo / 2] = u - v;
+			}
+	}
+
+	free(giro);
+	return 0;
+}
+
+static double complex potencia(double complex base, int k){
+	double complex resultado = 1;
+	while (k > 0) {
+		if (k & 1)
+			resultado *= base;
+		base *= base;
+		k >>= 1;
+	}
+	return resultado;
+}
+
+/*
+ * Devuelve un arreglo con P(suma = k + j) para j = 0 .. k(n - 1), o NULL si
+ * no hay memoria. En *longitud queda k(n - 1) + 1. 'probabilidad' da la
+ * probabilidad de cada cara de un dado; NULL para un dado justo.
+ */
+double *suma_exacta(const double *probabilidad, int n, int k, size_t *longitud){
+	size_t largo = (size_t)k * (n - 1) + 1, m = 1;
+	while (m < largo)
+		m <<= 1;
+
+	double complex *x = calloc(m, sizeof(double complex));
+	double *pmf = malloc(largo * sizeof(double));
+	if (x == NULL || pmf == NULL) {
+		free(x);
+		free(pmf);
+		return NULL;
+	}
+
+	for (int c = 0; c < n; c++)
+		x[c] = probabilidad != NULL ? probabilidad[c] : 1.0 / n;
+	if (fft(x, m, 0) != 0) {
+		free(x);
+		free(pmf);
+		return NULL;
+	}
+	for (size_t j = 0; j < m; j++)
+		x[j] = potencia(x[j], k);
+	if (fft(x, m, 1) != 0) {
+		free(x);
+		free(pmf);
+		return NULL;
+	}
+
+	// El redondeo deja residuos del orden de 1e-17 en las colas
+	for (size_t j = 0; j < largo; j++) {
+		double p = creal(x[j]) / m;
+		pmf[j] = p > 0 ? p : 0;
+	}
+
+	free(x);
+	*longitud = largo;
+	return pmf;
+}
+
+#endif
@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "../comun/grafica.h"
+
+double densidad_exponencial(double x, const void *parametro) {
+    double lambda = *(const double *)parametro;
+    return x < 0 ? 0 : lambda * exp(-lambda * x);
+}
+
+int main() {
+    FILE *archivo = fopen("Dataset.csv", "r");
+    if (archivo == NULL) {
+        printf("Error al procesar el archivo: no se pudo abrir 'Dataset.csv'.\n");
+        return 1;
+    }
+
+    // 1. Leer la columna x (la primera es el indice)
+    size_t n = 0, capacidad = 1024;
+    double *datos = malloc(capacidad * sizeof(double)), suma = 0;
+    char linea[256];
+
+    fgets(linea, sizeof(linea), archivo); // Saltar encabezado (,x)
+    while (datos != NULL && fgets(linea, sizeof(linea), archivo)) {
+        double x;
+        if (sscanf(linea, "%*[^,],%lf", &x) != 1)
+            continue;
+        if (n == capacidad) {
+            double *mas = realloc(datos, 2 * capacidad * sizeof(double));
+            if (mas == NULL) {
+                free(datos);
+                datos = NULL;
+                break;
+            }
+            datos = mas;
+            capacidad *= 2;
+        }
+        datos[n++] = x;
+        suma += x;
+    }
+    fclose(archivo);
+
+    if (datos == NULL || n == 0) {
+        printf("Error al procesar el archivo: no hay datos.\n");
+        free(datos);
+        return 1;
+    }
+
+    // 2. Estimar lambda como el inverso de la media
+    double lambda = n / suma;
+    char leyenda[64];
+    snprintf(leyenda, sizeof(leyenda), "Curva Teórica (λ=%.2f)", lambda);
+    printf("Media = %.6f, lambda = %.4f con %zu datos\n", suma / n, lambda, n);
+
+    // 3. Histograma de densidad con 50 clases y la curva teorica encima
+    if (grafica_histograma("grafica_exponencial.svg", "Distribución Exponencial del Dataset",
+                           "Valor de X", "Densidad de Probabilidad", datos, n, 50,
+                           densidad_exponencial, &lambda, leyenda) != 0) {
+        printf("Error al graficar.\n");
+        free(datos);
+        return 1;
+    }
+    printf("Gráfica guardada como 'grafica_exponencial.svg'\n");
+
+    free(datos);
+    return 0;
+}
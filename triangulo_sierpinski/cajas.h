@@ -0,0 +1,118 @@
+#ifndef CAJAS_H
+#define CAJAS_H
+
+/*
+ * Dimension fractal por conteo de cajas, al vuelo.
+ *
+ * El cuadrado que contiene al atractor se parte en 2^l x 2^l cajas para cada
+ * nivel l = 0 .. NIVELES_CAJAS - 1 y de cada nivel se guarda un bit por caja
+ * (ocupada o no) y cuantas cajas van ocupadas. Si una caja de un nivel ya
+ * estaba ocupada, las que la contienen en los niveles mas gruesos tambien, asi
+ * que un punto nuevo se revisa del nivel mas fino hacia arriba y se para en
+ * cuanto encuentra un bit prendido: a lo mas NIVELES_CAJAS pasos y casi
+ * siempre uno solo.
+ *
+ * La dimension es la pendiente de log N(l) contra l log 2 por minimos
+ * cuadrados, usando solo los niveles con suficientes puntos por caja.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#define NIVELES_CAJAS 12
+#define NIVEL_MINIMO_AJUSTE 2
+#define PUNTOS_POR_CAJA 32
+
+typedef struct {
+	uint64_t *bits[NIVELES_CAJAS];
+	uint64_t ocupadas[NIVELES_CAJAS];
+	double x0, y0, escala;          // caja fina = (punto - origen) * escala
+	unsigned long long puntos;
+} Cajas;
+
+// 'caja' es {x_min, x_max, y_min, y_max}; se usa el cuadrado que la contiene.
+int cajas_crear(Cajas *c, const double caja[4]){
+	double lado = fmax(caja[1] - caja[0], caja[3] - caja[2]);
+	c->x0 = caja[0];
+	c->y0 = caja[2];
+	c->escala = (1 << (NIVELES_CAJAS - 1)) / lado;
+	c->puntos = 0;
+
+	int error = 0;
+	for (int l = 0; l < NIVELES_CAJAS; l++) {
+		c->bits[l] = calloc(((size_t)1 << (2 * l)) / 64 + 1, sizeof(uint64_t));
+		c->ocupadas[l] = 0;
+		error |= c->bits[l] == NULL;
+	}
+	return error ? -1 : 0;
+}
+
+void cajas_destruir(Cajas *c){
+	for (int l = 0; l < NIVELES_CAJAS; l++)
+		free(c->bits[l]);
+}
+
+/*
+ * Agrega n puntos. Primero se calcula la caja fina de cada uno (se vectoriza;
+ * los que caen fuera quedan marcados con -1) y despues se suben los
+ * bits nivel por nivel hasta topar con uno prendido.
+ */
+void cajas_agregar(Cajas *c, const double *x, const double *y, int n){
+	int32_t finas[256];
+	double tope = 1 << (NIVELES_CAJAS - 1);
+
+	c->puntos += n;
+	for (int base = 0; base < n; base += 256) {
+		int tramo = n - base < 256 ? n - base : 256;
+		for (int i = 0; i < tramo; i++) {
+			double fx = (x[base + i] - c->x0) * c->escala, fy = (y[base + i] - c->y0) * c->escala;
+			int dentro = (fx >= 0) & (fx < tope) & (fy >= 0) & (fy < tope);
+			finas[i] = dentro ? ((int32_t)fy << (NIVELES_CAJAS - 1)) | (int32_t)fx : -1;
+		}
+
+		for (int i = 0; i < tramo; i++) {
+			if (finas[i] < 0)
+				continue;
+			uint32_t ix = finas[i] & ((1u << (NIVELES_CAJAS - 1)) - 1);
+			uint32_t iy = finas[i] >> (NIVELES_CAJAS - 1);
+			for (int l = NIVELES_CAJAS - 1; l >= 0; l--, ix >>= 1, iy >>= 1) {
+				uint64_t k = ((uint64_t)iy << l) | ix;
+				uint64_t mascara = 1ULL << (k & 63), *palabra = &c->bits[l][k >> 6];
+				if (*palabra & mascara)
+					break;
+				*palabra |= mascara;
+				c->ocupadas[l]++;
+			}
+		}
+	}
+}
+
+/*
+ * Pendiente de log N contra log(2^l) en los niveles desde NIVEL_MINIMO_AJUSTE
+ * hasta el mas fino que tenga en promedio PUNTOS_POR_CAJA puntos por caja
+ * ocupada. Devuelve NAN si todavia no hay al menos dos niveles asi; en
+ * *hasta queda el ultimo nivel usado.
+ */
+double cajas_dimension(const Cajas *c, int *hasta){
+	double sx = 0, sy = 0, sxx = 0, sxy = 0;
+	int n = 0;
+
+	*hasta = NIVEL_MINIMO_AJUSTE - 1;
+	for (int l = NIVEL_MINIMO_AJUSTE; l < NIVELES_CAJAS; l++) {
+		if (c->ocupadas[l] == 0 || c->ocupadas[l] * PUNTOS_POR_CAJA > c->puntos)
+			break;
+		double x = l * M_LN2, y = log((double)c->ocupadas[l]);
+		sx += x;
+		sy += y;
+		sxx += x * x;
+		sxy += x * y;
+		n++;
+		*hasta = l;
+	}
+	if (n < 2)
+		return NAN;
+	return (n * sxy - sx * sy) / (n * sxx - sx * sx);
+}
+
+#endif
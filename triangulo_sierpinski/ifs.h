@@ -0,0 +1,203 @@
+#ifndef IFS_H
+#define IFS_H
+
+/*
+ * Sistema de funciones iteradas (IFS): n mapas afines
+ *     x' = a x + b y + e
+ *     y' = c x + d y + f
+ * cada uno con probabilidad p. El juego del caos del triangulo es el caso de
+ * tres mapas con a = d = 1/2 y (e, f) = vertice / 2.
+ *
+ * Se avanzan ORBITAS orbitas independientes a la vez, guardadas como
+ * estructura de arreglos (x[], y[] y el estado de un xoshiro256** por orbita)
+ * para que el compilador vectorice el paso completo: generar el aleatorio,
+ * escoger el mapa sin saltos y aplicarlo. El mapa se escoge comparando contra
+ * las probabilidades acumuladas y luego cada mapa se aplica a todo el bloque
+ * quedandose solo donde toca, que es lo que se vectoriza sin gathers; con los
+ * pocos mapas de un IFS tipico eso sale mas barato que indexar.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include "../comun/aleatorio.h"
+
+#define MAX_MAPAS 32
+#define ORBITAS 4096
+#define BLOQUE_ORBITAS 256
+
+typedef struct {
+	int n;
+	double a[MAX_MAPAS], b[MAX_MAPAS], c[MAX_MAPAS];
+	double d[MAX_MAPAS], e[MAX_MAPAS], f[MAX_MAPAS];
+	uint32_t acumulada[MAX_MAPAS];   // P(mapa <= j) * 2^32
+} Ifs;
+
+typedef struct {
+	_Alignas(64) double x[ORBITAS];
+	_Alignas(64) double y[ORBITAS];
+	_Alignas(64) uint64_t s0[ORBITAS];
+	_Alignas(64) uint64_t s1[ORBITAS];
+	_Alignas(64) uint64_t s2[ORBITAS];
+	_Alignas(64) uint64_t s3[ORBITAS];
+	_Alignas(64) uint32_t previo[ORBITAS];   // ultimo vertice (juego del caos con reglas)
+} Orbitas;
+
+// Normaliza las probabilidades p[0..n) y arma la tabla acumulada.
+int ifs_armar(Ifs *ifs, const double *p){
+	double total = 0, suma = 0;
+	for (int j = 0; j < ifs->n; j++) {
+		if (!(p[j] >= 0))
+			return -1;
+		total += p[j];
+	}
+	if (ifs->n == 0 || total <= 0)
+		return -1;
+
+	for (int j = 0; j < ifs->n; j++) {
+		suma += p[j] / total;
+		double u = suma * 4294967296.0;
+		ifs->acumulada[j] = u >= 4294967295.0 ? UINT32_MAX : (uint32_t)u;
+	}
+	return 0;
+}
+
+/*
+ * Lee un mapa por renglon: "a b c d e f p". Los renglones vacios o que
+ * empiezan con # se ignoran. Devuelve -1 si el archivo no se puede leer, un
+ * renglon esta incompleto o hay mas de MAX_MAPAS mapas.
+ */
+int ifs_cargar(Ifs *ifs, const char *nombre){
+	FILE *archivo = fopen(nombre, "r");
+	if (archivo == NULL)
+		return -1;
+
+	double p[MAX_MAPAS];
+	char linea[256];
+	int error = 0;
+
+	ifs->n = 0;
+	while (fgets(linea, sizeof(linea), archivo)) {
+		char *inicio = linea;
+		while (*inicio == ' ' || *inicio == '\t')
+			inicio++;
+		if (*inicio == '#' || *inicio == '\n' || *inicio == '\r' || *inicio == '\0')
+			continue;
+
+		int j = ifs->n;
+		if (j == MAX_MAPAS ||
+		    sscanf(inicio, "%lf %lf %lf %lf %lf %lf %lf", &ifs->a[j], &ifs->b[j], &ifs->c[j],
+		           &ifs->d[j], &ifs->e[j], &ifs->f[j], &p[j]) != 7) {
+			error = 1;
+			break;
+		}
+		ifs->n++;
+	}
+	fclose(archivo);
+
+	return error ? -1 : ifs_armar(ifs, p);
+}
+
+// Tres mapas que llevan cada punto a la mitad del camino hacia un vertice.
+void ifs_triangulo(Ifs *ifs, const double vertices[3][2]){
+	double p[3] = {1, 1, 1};
+	ifs->n = 3;
+	for (int j = 0; j < 3; j++) {
+		ifs->a[j] = ifs->d[j] = 0.5;
+		ifs->b[j] = ifs->c[j] = 0;
+		ifs->e[j] = vertices[j][0] * 0.5;
+		ifs->f[j] = vertices[j][1] * 0.5;
+	}
+	ifs_armar(ifs, p);
+}
+
+// Cada flujo (un hilo, por ejemplo) siembra sus orbitas con su propio generador.
+void orbitas_iniciar(Orbitas *o, uint64_t semilla, uint64_t flujo){
+	Generador g;
+	generador_iniciar(&g, semilla, flujo);
+	for (int i = 0; i < ORBITAS; i++) {
+		uint64_t mezcla = generador_u64(&g);
+		o->s0[i] = splitmix64(&mezcla);
+		o->s1[i] = splitmix64(&mezcla);
+		o->s2[i] = splitmix64(&mezcla);
+		o->s3[i] = splitmix64(&mezcla);
+		o->x[i] = generador_uniforme(&g);
+		o->y[i] = generador_uniforme(&g);
+		o->previo[i] = 0;
+	}
+}
+
+// Avanza el xoshiro256** de las orbitas base .. base + BLOQUE_ORBITAS y deja
+// en r los 32 bits altos de cada salida.
+static inline void orbitas_aleatorios(Orbitas *o, int base, uint32_t *restrict r){
+	uint64_t *restrict s0 = o->s0 + base, *restrict s1 = o->s1 + base;
+	uint64_t *restrict s2 = o->s2 + base, *restrict s3 = o->s3 + base;
+
+	for (int i = 0; i < BLOQUE_ORBITAS; i++) {
+		uint64_t t = s1[i] * 5;
+		r[i] = (uint32_t)((((t << 7) | (t >> 57)) * 9) >> 32);
+		t = s1[i] << 17;
+		s2[i] ^= s0[i];
+		s3[i] ^= s1[i];
+		s1[i] ^= s2[i];
+		s0[i] ^= s3[i];
+		s2[i] ^= t;
+		s3[i] = (s3[i] << 45) | (s3[i] >> 19);
+	}
+}
+
+/*
+ * Un paso de todas las orbitas. Cada clon se compila para un conjunto de
+ * instrucciones y el cargador escoge el mejor que soporte el procesador.
+ */
+__attribute__((target_clones("avx512f", "avx2", "default")))
+void ifs_paso(const Ifs *ifs, Orbitas *o){
+	for (int base = 0; base < ORBITAS; base += BLOQUE_ORBITAS) {
+		double *restrict x = o->x + base, *restrict y = o->y + base;
+		uint32_t r[BLOQUE_ORBITAS];
+		int32_t k[BLOQUE_ORBITAS];
+
+		orbitas_aleatorios(o, base, r);
+
+		for (int i = 0; i < BLOQUE_ORBITAS; i++)
+			k[i] = 0;
+		for (int j = 0; j < ifs->n - 1; j++) {
+			uint32_t u = ifs->acumulada[j];
+			for (int i = 0; i < BLOQUE_ORBITAS; i++)
+				k[i] += r[i] >= u;
+		}
+
+		// Cada mapa se evalua en todos los carriles y se queda donde k lo pide
+		double nx[BLOQUE_ORBITAS], ny[BLOQUE_ORBITAS];
+		for (int i = 0; i < BLOQUE_ORBITAS; i++) {
+			nx[i] = ifs->a[0] * x[i] + ifs->b[0] * y[i] + ifs->e[0];
+			ny[i] = ifs->c[0] * x[i] + ifs->d[0] * y[i] + ifs->f[0];
+		}
+		for (int j = 1; j < ifs->n; j++) {
+			double a = ifs->a[j], b = ifs->b[j], c = ifs->c[j];
+			double d = ifs->d[j], e = ifs->e[j], f = ifs->f[j];
+			for (int i = 0; i < BLOQUE_ORBITAS; i++) {
+				int m = k[i] == j;
+				nx[i] = m ? a * x[i] + b * y[i] + e : nx[i];
+				ny[i] = m ? c * x[i] + d * y[i] + f : ny[i];
+			}
+		}
+		for (int i = 0; i < BLOQUE_ORBITAS; i++) {
+			x[i] = nx[i];
+			y[i] = ny[i];
+		}
+	}
+}
+
+// Amplia caja = {x_min, x_max, y_min, y_max} para contener todas las orbitas.
+void orbitas_ampliar_caja(const Orbitas *o, double caja[4]){
+	for (int i = 0; i < ORBITAS; i++) {
+		caja[0] = fmin(caja[0], o->x[i]);
+		caja[1] = fmax(caja[1], o->x[i]);
+		caja[2] = fmin(caja[2], o->y[i]);
+		caja[3] = fmax(caja[3], o->y[i]);
+	}
+}
+
+#endif
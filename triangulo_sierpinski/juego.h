@@ -0,0 +1,109 @@
+#ifndef JUEGO_H
+#define JUEGO_H
+
+/*
+ * Juego del caos en un poligono regular de n lados: en cada paso se escoge un
+ * vertice al azar y el punto avanza una fraccion 'razon' del camino hacia el.
+ * Las reglas de restriccion dependen del vertice anterior, asi que esto no es
+ * un IFS; todas se escriben como
+ *     v = (previo + DESPLAZAMIENTO + r) mod n,   r uniforme en [0, n - EXCLUIDOS)
+ * porque los vertices permitidos siempre forman un tramo seguido del poligono.
+ *
+ * Cada regla tiene su propio nucleo, generado por DEFINIR_PASO_JUEGO con sus
+ * constantes fijas, de modo que dentro del ciclo no se pregunta por la regla;
+ * se escoge el nucleo una vez al iniciar. Las posiciones de los vertices (ya
+ * multiplicadas por la razon) se calculan tambien una sola vez en una tabla.
+ */
+
+#include <string.h>
+#include <math.h>
+#include "ifs.h"
+
+#define MAX_VERTICES 64
+
+enum { NINGUNA, NO_REPETIR, NO_SIGUIENTE, NO_CERCANOS, REGLAS };
+
+static const char *const NOMBRES_REGLAS[REGLAS] = {
+	"ninguna",        // cualquier vertice
+	"no_repetir",     // distinto del anterior
+	"no_siguiente",   // no el que sigue al anterior en sentido antihorario
+	"no_cercanos",    // ni el anterior ni sus dos vecinos
+};
+
+typedef struct Juego Juego;
+typedef void (*PasoJuego)(const Juego *, Orbitas *);
+
+struct Juego {
+	uint32_t n;
+	double razon;
+	int regla;
+	double vx[MAX_VERTICES], vy[MAX_VERTICES];    // vertices, radio 1
+	double tx[MAX_VERTICES], ty[MAX_VERTICES];    // razon * vertice
+	PasoJuego paso;
+};
+
+#define DEFINIR_PASO_JUEGO(nombre, DESPLAZAMIENTO, EXCLUIDOS, USA_PREVIO)                     \
+__attribute__((target_clones("avx512f", "avx2", "default")))                                 \
+static void juego_paso_##nombre(const Juego *j, Orbitas *o){                                 \
+	const uint32_t n = j->n, m = j->n - (EXCLUIDOS);                                        \
+	const double q = 1 - j->razon;                                                          \
+	for (int base = 0; base < ORBITAS; base += BLOQUE_ORBITAS) {                            \
+		double *restrict x = o->x + base, *restrict y = o->y + base;                        \
+		uint32_t *restrict previo = o->previo + base;                                       \
+		uint32_t r[BLOQUE_ORBITAS];                                                         \
+		orbitas_aleatorios(o, base, r);                                                     \
+		for (int i = 0; i < BLOQUE_ORBITAS; i++) {                                          \
+			uint32_t v = (uint32_t)(((uint64_t)r[i] * m) >> 32);                            \
+			if (USA_PREVIO) {                                                               \
+				v += previo[i] + (DESPLAZAMIENTO);                                          \
+				v -= v >= n ? n : 0;                                                        \
+				previo[i] = v;                                                              \
+			}                                                                               \
+			x[i] = q * x[i] + j->tx[v];                                                     \
+			y[i] = q * y[i] + j->ty[v];                                                     \
+		}                                                                                   \
+	}                                                                                       \
+}
+
+DEFINIR_PASO_JUEGO(ninguna, 0, 0, 0)
+DEFINIR_PASO_JUEGO(no_repetir, 1, 1, 1)
+DEFINIR_PASO_JUEGO(no_siguiente, 2, 1, 1)
+DEFINIR_PASO_JUEGO(no_cercanos, 2, 3, 1)
+
+static const PasoJuego PASOS_JUEGO[REGLAS] = {
+	juego_paso_ninguna, juego_paso_no_repetir, juego_paso_no_siguiente, juego_paso_no_cercanos,
+};
+
+// Regla por nombre, o -1 si no existe.
+int juego_regla(const char *nombre){
+	for (int k = 0; k < REGLAS; k++)
+		if (strcmp(nombre, NOMBRES_REGLAS[k]) == 0)
+			return k;
+	return -1;
+}
+
+/*
+ * Poligono de n lados con el primer vertice arriba. Devuelve -1 si n esta
+ * fuera de rango o la regla deja menos de un vertice para escoger.
+ */
+int juego_iniciar(Juego *j, uint32_t n, double razon, int regla){
+	static const uint32_t EXCLUIDOS[REGLAS] = {0, 1, 1, 3};
+	if (n < 3 || n > MAX_VERTICES || regla < 0 || regla >= REGLAS || n <= EXCLUIDOS[regla] ||
+	    !(razon > 0 && razon < 1))
+		return -1;
+
+	j->n = n;
+	j->razon = razon;
+	j->regla = regla;
+	j->paso = PASOS_JUEGO[regla];
+	for (uint32_t k = 0; k < n; k++) {
+		double angulo = M_PI / 2 + 2 * M_PI * k / n;
+		j->vx[k] = cos(angulo);
+		j->vy[k] = sin(angulo);
+		j->tx[k] = razon * j->vx[k];
+		j->ty[k] = razon * j->vy[k];
+	}
+	return 0;
+}
+
+#endif
@@ -1,69 +1,569 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include <time.h>
 #include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <CSFML/Graphics.h>
+#include "../comun/aleatorio.h"
+#include "../comun/png.h"
+#include "ifs.h"
+#include "juego.h"
+#include "cajas.h"
+
+#define ANCHO 1366
+#define ALTO 768
+#define LOTE_MAXIMO (1 << 20)
 
 const double Radian = 3.1416 / 180.0;
 
+/*
+ * Lo que se itera: un IFS o el juego del caos con reglas. Se decide una vez
+ * por paso de ORBITAS puntos, nunca dentro del ciclo de cada punto.
+ */
+typedef struct {
+	Ifs ifs;
+	Juego juego;
+	int es_juego;
+} Sistema;
+
+static void sistema_paso(const Sistema *s, Orbitas *o) {
+	if (s->es_juego)
+		s->juego.paso(&s->juego, o);
+	else
+		ifs_paso(&s->ifs, o);
+}
+
+/*
+ * Calienta las orbitas para que caigan en el atractor y mide su caja
+ * envolvente, con un margen del 2%.
+ */
+void medir_caja(const Sistema *s, Orbitas *o, double caja[4]) {
+	for (int paso = 0; paso < 64; paso++)
+		sistema_paso(s, o);
+
+	caja[0] = caja[2] = INFINITY;
+	caja[1] = caja[3] = -INFINITY;
+	for (int paso = 0; paso < 64; paso++) {
+		sistema_paso(s, o);
+		orbitas_ampliar_caja(o, caja);
+	}
+
+	double mx = (caja[1] - caja[0]) * 0.02 + 1e-9, my = (caja[3] - caja[2]) * 0.02 + 1e-9;
+	caja[0] -= mx;
+	caja[1] += mx;
+	caja[2] -= my;
+	caja[3] += my;
+}
+
+/*
+ * La iteracion corre en su propio hilo, en lotes de pasos del IFS sobre todas
+ * las orbitas, y acumula en 'densidad'. Para mostrarla la copia en el buffer
+ * trasero y lo publica: 'frente' dice cual buffer es el bueno y 'nuevo' vale 1
+ * mientras la ventana no lo haya terminado de leer. El trabajador solo escribe en el buffer que
+ * no es el frente y solo cambia el frente cuando 'nuevo' es 0, asi que nadie
+ * espera a nadie.
+ */
+typedef struct {
+	Sistema sistema;
+	double escala[2], origen[2];     // pixel = escala * punto + origen
+	double objetivo;                 // iteraciones por segundo, 0 = sin limite
+	uint32_t *densidad;
+	uint32_t *buffers[2];
+	uint32_t maximos[2];
+	atomic_int frente, nuevo, terminar;
+	atomic_ullong iteraciones;
+	_Atomic double dimension;        // estimada por conteo de cajas
+	atomic_int nivel;                // nivel mas fino usado en la estimacion
+	unsigned long long semilla;
+} Caos;
+
+/*
+ * Un renglon de dimension.csv: puntos, dimension estimada, ultimo nivel del
+ * ajuste y cajas ocupadas en cada nivel.
+ */
+void escribir_dimension(FILE *csv, const Cajas *c, double dimension, int nivel) {
+	fprintf(csv, "%llu,%.6f,%d", c->puntos, dimension, nivel);
+	for (int l = 0; l < NIVELES_CAJAS; l++)
+		fprintf(csv, ",%llu", (unsigned long long)c->ocupadas[l]);
+	fprintf(csv, "\n");
+	fflush(csv);
+}
+
+static double segundos(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/*
+ * Suma en 'densidad' (ancho x alto, mas una celda extra al final para lo que
+ * cae fuera) la posicion actual de todas las orbitas. Primero se sacan los
+ * indices, que se vectoriza, y luego se hacen las sumas.
+ */
+void acumular(const Orbitas *o, const double escala[2], const double origen[2],
+              int ancho, int alto, uint32_t *indices, uint32_t *densidad) {
+	uint32_t fuera = (uint32_t)ancho * alto;
+	for (int i = 0; i < ORBITAS; i++) {
+		double px = o->x[i] * escala[0] + origen[0];
+		double py = o->y[i] * escala[1] + origen[1];
+		int dentro = px >= 0 && px < ancho && py >= 0 && py < alto;
+		indices[i] = dentro ? (uint32_t)py * ancho + (uint32_t)px : fuera;
+	}
+	for (int i = 0; i < ORBITAS; i++) {
+		uint32_t *celda = &densidad[indices[i]];
+		*celda += *celda != UINT32_MAX;
+	}
+}
+
+void *iterar(void *arg) {
+	Caos *caos = arg;
+	Orbitas *o = aligned_alloc(64, sizeof(Orbitas));
+	uint32_t *indices = malloc(ORBITAS * sizeof(uint32_t));
+	double inicio = segundos(), caja[4];
+	unsigned long long hechas = 0, siguiente_registro = 1ULL << 16;
+	Cajas cajas;
+	FILE *csv = fopen("dimension.csv", "w");
+
+	if (o == NULL || indices == NULL) {
+		free(o);
+		free(indices);
+		fprintf(stderr, "Error: memoria insuficiente para las orbitas.\n");
+		return NULL;
+	}
+	orbitas_iniciar(o, caos->semilla, 0);
+	medir_caja(&caos->sistema, o, caja);
+	if (cajas_crear(&cajas, caja) != 0) {
+		cajas_destruir(&cajas);
+		free(o);
+		free(indices);
+		fprintf(stderr, "Error: memoria insuficiente para el conteo de cajas.\n");
+		return NULL;
+	}
+	if (csv != NULL) {
+		fprintf(csv, "Puntos,Dimension,Nivel");
+		for (int l = 0; l < NIVELES_CAJAS; l++)
+			fprintf(csv, ",Cajas%d", l);
+		fprintf(csv, "\n");
+	}
+
+	while (!atomic_load(&caos->terminar)) {
+		long pasos = LOTE_MAXIMO / ORBITAS;
+		if (caos->objetivo > 0) {
+			// Unos 120 lotes por segundo; si vamos adelantados, se espera
+			pasos = (long)(caos->objetivo / 120 / ORBITAS) + 1;
+			if (pasos > LOTE_MAXIMO / ORBITAS)
+				pasos = LOTE_MAXIMO / ORBITAS;
+			double adelanto = hechas / caos->objetivo - (segundos() - inicio);
+			if (adelanto > 0) {
+				struct timespec pausa = {(time_t)adelanto, (long)((adelanto - (time_t)adelanto) * 1e9)};
+				nanosleep(&pausa, NULL);
+			}
+		}
+
+		for (long paso = 0; paso < pasos; paso++) {
+			sistema_paso(&caos->sistema, o);
+			acumular(o, caos->escala, caos->origen, ANCHO, ALTO, indices, caos->densidad);
+			cajas_agregar(&cajas, o->x, o->y, ORBITAS);
+		}
+		hechas += (unsigned long long)pasos * ORBITAS;
+		atomic_store(&caos->iteraciones, hechas);
+
+		int nivel;
+		double dimension = cajas_dimension(&cajas, &nivel);
+		atomic_store(&caos->dimension, dimension);
+		atomic_store(&caos->nivel, nivel);
+		// Un registro cada vez que se duplican los puntos
+		if (csv != NULL && hechas >= siguiente_registro) {
+			escribir_dimension(csv, &cajas, dimension, nivel);
+			while (siguiente_registro <= hechas)
+				siguiente_registro <<= 1;
+		}
+
+		if (!atomic_load(&caos->nuevo)) {
+			int trasero = 1 - atomic_load(&caos->frente);
+			uint32_t maximo = 0;
+			for (int p = 0; p < ANCHO * ALTO; p++) {
+				caos->buffers[trasero][p] = caos->densidad[p];
+				maximo = caos->densidad[p] > maximo ? caos->densidad[p] : maximo;
+			}
+			caos->maximos[trasero] = maximo;
+			atomic_store(&caos->frente, trasero);
+			atomic_store(&caos->nuevo, 1);
+		}
+	}
+	if (csv != NULL) {
+		int nivel;
+		escribir_dimension(csv, &cajas, cajas_dimension(&cajas, &nivel), nivel);
+		fclose(csv);
+	}
+	cajas_destruir(&cajas);
+	free(o);
+	free(indices);
+	return NULL;
+}
+
+/*
+ * Ajusta la caja del atractor a una imagen de ancho x alto sin deformarlo.
+ * Con 'voltear' el eje y del IFS apunta hacia arriba (el de la imagen apunta
+ * hacia abajo).
+ */
+void ajustar_vista(double escala[2], double origen[2], const double caja[4],
+                   int ancho, int alto, int voltear) {
+	double w = caja[1] - caja[0], h = caja[3] - caja[2];
+	double e = fmin(ancho / w, alto / h);
+	escala[0] = e;
+	origen[0] = (ancho - e * w) / 2 - e * caja[0];
+	escala[1] = voltear ? -e : e;
+	origen[1] = voltear ? (alto + e * h) / 2 + e * caja[2] : (alto - e * h) / 2 - e * caja[2];
+}
+
+/*
+ * Render sin ventana para muchos puntos: cada hilo tiene su flujo de
+ * aleatorios, sus orbitas y su propia rejilla de 32 bits, asi que no hay
+ * contencion al acumular. Para que ninguna celda privada se desborde, el
+ * trabajo se parte en rondas de a lo mas LIMITE_RONDA puntos por hilo; al
+ * final de cada ronda los hilos se esperan y cada uno suma una franja de
+ * renglones de todas las rejillas privadas en la rejilla total de 64 bits.
+ */
+#define LIMITE_RONDA ((UINT32_MAX / ORBITAS - 1) * (unsigned long long)ORBITAS)
+
+typedef struct {
+	const Sistema *sistema;
+	double escala[2], origen[2];
+	int ancho, alto, hilos;
+	unsigned long long pasos_hilo;   // pasos de ORBITAS puntos por hilo
+	unsigned long long semilla;
+	uint32_t **privadas;
+	uint64_t *total;
+	pthread_barrier_t barrera;
+} Render;
+
+typedef struct {
+	Render *render;
+	int hilo;
+} TareaRender;
+
+void *renderizar_hilo(void *arg) {
+	TareaRender *tarea = arg;
+	Render *r = tarea->render;
+	Orbitas *o = aligned_alloc(64, sizeof(Orbitas));
+	uint32_t *indices = malloc(ORBITAS * sizeof(uint32_t));
+	uint32_t *propia = r->privadas[tarea->hilo];
+	double caja[4];
+
+	// Si falta memoria, el hilo no suma puntos pero sigue en las barreras
+	if (o != NULL && indices != NULL) {
+		orbitas_iniciar(o, r->semilla, tarea->hilo);
+		medir_caja(r->sistema, o, caja);
+	}
+
+	size_t celdas = (size_t)r->ancho * r->alto;
+	size_t desde = celdas * tarea->hilo / r->hilos, hasta = celdas * (tarea->hilo + 1) / r->hilos;
+	unsigned long long por_ronda = LIMITE_RONDA / ORBITAS;
+
+	for (unsigned long long hechos = 0; hechos < r->pasos_hilo; hechos += por_ronda) {
+		unsigned long long pasos = r->pasos_hilo - hechos < por_ronda ? r->pasos_hilo - hechos : por_ronda;
+		for (unsigned long long paso = 0; o != NULL && indices != NULL && paso < pasos; paso++) {
+			sistema_paso(r->sistema, o);
+			acumular(o, r->escala, r->origen, r->ancho, r->alto, indices, propia);
+		}
+
+		pthread_barrier_wait(&r->barrera);
+		for (int h = 0; h < r->hilos; h++) {
+			uint32_t *privada = r->privadas[h];
+			for (size_t c = desde; c < hasta; c++) {
+				r->total[c] += privada[c];
+				privada[c] = 0;
+			}
+		}
+		pthread_barrier_wait(&r->barrera);
+	}
+
+	if (o == NULL || indices == NULL)
+		fprintf(stderr, "Error: memoria insuficiente en el hilo %d.\n", tarea->hilo);
+	free(o);
+	free(indices);
+	return NULL;
+}
+
+/*
+ * Corre 'puntos' iteraciones repartidas en 'hilos' hilos y guarda la densidad
+ * como PNG de 16 bits en gris con el mismo tono logaritmico de la ventana.
+ */
+int renderizar(const Sistema *sistema, int voltear, int ancho, int alto, int hilos,
+               unsigned long long puntos, unsigned long long semilla, const char *nombre) {
+	Render r = {.sistema = sistema, .ancho = ancho, .alto = alto, .hilos = hilos, .semilla = semilla};
+	size_t celdas = (size_t)ancho * alto;
+	unsigned long long pasos = (puntos + ORBITAS - 1) / ORBITAS;
+	r.pasos_hilo = (pasos + hilos - 1) / hilos;
+
+	Orbitas *prueba = aligned_alloc(64, sizeof(Orbitas));
+	double caja[4];
+	if (prueba == NULL)
+		return -1;
+	orbitas_iniciar(prueba, semilla, 0);
+	medir_caja(sistema, prueba, caja);
+	free(prueba);
+	ajustar_vista(r.escala, r.origen, caja, ancho, alto, voltear);
+
+	int error = 0;
+	r.total = calloc(celdas, sizeof(uint64_t));
+	r.privadas = calloc(hilos, sizeof(uint32_t *));
+	error = r.total == NULL || r.privadas == NULL;
+	for (int h = 0; !error && h < hilos; h++) {
+		r.privadas[h] = calloc(celdas + 1, sizeof(uint32_t));
+		error = r.privadas[h] == NULL;
+	}
+
+	TareaRender *tareas = malloc(hilos * sizeof(TareaRender));
+	pthread_t *ids = malloc(hilos * sizeof(pthread_t));
+	if (!error && tareas != NULL && ids != NULL) {
+		double inicio = segundos();
+		pthread_barrier_init(&r.barrera, NULL, hilos);
+		for (int h = 0; h < hilos; h++) {
+			tareas[h] = (TareaRender){&r, h};
+			pthread_create(&ids[h], NULL, renderizar_hilo, &tareas[h]);
+		}
+		for (int h = 0; h < hilos; h++)
+			pthread_join(ids[h], NULL);
+		pthread_barrier_destroy(&r.barrera);
+
+		double tiempo = segundos() - inicio;
+		unsigned long long hechos = r.pasos_hilo * hilos * ORBITAS;
+		printf("%llu puntos en %.2f s (%.2f M it/s) con %d hilos\n", hechos, tiempo,
+		       hechos / tiempo / 1e6, hilos);
+
+		uint64_t maximo = 0;
+		for (size_t c = 0; c < celdas; c++)
+			maximo = r.total[c] > maximo ? r.total[c] : maximo;
+
+		// Se reutiliza la primera rejilla privada para los pixeles de 16 bits
+		uint16_t *pixeles = (uint16_t *)r.privadas[0];
+		double escala = maximo > 0 ? 65535.0 / log1p((double)maximo) : 0;
+		for (size_t c = 0; c < celdas; c++)
+			pixeles[c] = (uint16_t)(log1p((double)r.total[c]) * escala + 0.5);
+		error = png_gris16(nombre, pixeles, ancho, alto) != 0;
+	} else
+		error = 1;
+
+	for (int h = 0; r.privadas != NULL && h < hilos; h++)
+		free(r.privadas[h]);
+	free(r.privadas);
+	free(r.total);
+	free(tareas);
+	free(ids);
+	return error ? -1 : 0;
+}
+
+/*
+ * Cada pixel se pinta segun log(1 + hits) / log(1 + maximo), asi que la
+ * memoria y el costo de dibujo no dependen de cuantos puntos se lleven.
+ */
+void tono_logaritmico(const uint32_t *densidad, uint32_t maximo, uint8_t *pixeles) {
+	double escala = maximo > 0 ? 255.0 / log1p(maximo) : 0;
+	for (int p = 0; p < ANCHO * ALTO; p++) {
+		uint8_t v = (uint8_t)(log1p(densidad[p]) * escala);
+		pixeles[4 * p + 0] = 0;
+		pixeles[4 * p + 1] = v;
+		pixeles[4 * p + 2] = 0;
+		pixeles[4 * p + 3] = 255;
+	}
+}
+
 int main(int argc, char **argv) {
+	Caos caos = {.objetivo = 0, .dimension = NAN, .semilla = (unsigned long long)time(NULL)};
+	const char *archivo_ifs = NULL, *salida = NULL, *nombre_regla = "ninguna";
+	int opcion, ancho = 4096, alto = 4096, hilos = (int)sysconf(_SC_NPROCESSORS_ONLN), lados = 0;
+	unsigned long long puntos = 10000000000ULL;
+	double razon = 0.5;
+
+	// -r iteraciones por segundo (0 = tan rapido como se pueda), -s semilla,
+	// -f archivo con los mapas del IFS (sin el, el triangulo de siempre).
+	// -g lados del poligono para el juego del caos, con -j razon de salto y
+	// -x regla (ninguna, no_repetir, no_siguiente, no_cercanos).
+	// Con -o no se abre ventana: se hace un render de -p puntos con -t hilos
+	// y se guarda como PNG de -a x -l pixeles.
+	while ((opcion = getopt(argc, argv, "r:s:f:g:j:x:o:a:l:p:t:")) != -1) {
+		switch (opcion) {
+		case 'r': caos.objetivo = atof(optarg); break;
+		case 's': caos.semilla = strtoull(optarg, NULL, 10); break;
+		case 'f': archivo_ifs = optarg; break;
+		case 'g': lados = atoi(optarg); break;
+		case 'j': razon = atof(optarg); break;
+		case 'x': nombre_regla = optarg; break;
+		case 'o': salida = optarg; break;
+		case 'a': ancho = atoi(optarg); break;
+		case 'l': alto = atoi(optarg); break;
+		case 'p': puntos = (unsigned long long)atof(optarg); break;
+		case 't': hilos = atoi(optarg); break;
+		default:
+			fprintf(stderr, "Uso: %s [-r iteraciones_por_segundo] [-s semilla]\n"
+			                "       [-f mapas.ifs | -g lados [-j razon] [-x regla]]\n"
+			                "       [-o imagen.png [-a ancho] [-l alto] [-p puntos] [-t hilos]]\n",
+			        argv[0]);
+			return 1;
+		}
+	}
+	if (archivo_ifs != NULL && lados > 0) {
+		printf("Error: -f y -g no se pueden usar juntos.\n");
+		return 1;
+	}
+	if (archivo_ifs != NULL && ifs_cargar(&caos.sistema.ifs, archivo_ifs) != 0) {
+		printf("Error: no se pudieron leer los mapas de %s.\n", archivo_ifs);
+		return 1;
+	}
+	if (lados > 0) {
+		if (juego_iniciar(&caos.sistema.juego, lados, razon, juego_regla(nombre_regla)) != 0) {
+			printf("Error: juego del caos invalido (%d lados, razon %g, regla %s).\n",
+			       lados, razon, nombre_regla);
+			return 1;
+		}
+		caos.sistema.es_juego = 1;
+	}
+	// El triangulo de siempre esta en pixeles; lo demas hay que ajustarlo
+	int en_pixeles = archivo_ifs == NULL && lados == 0;
 
-	srand(time(NULL));
-	
-	sfVideoMode mode = {1366, 768, 32};
-	sfRenderWindow *window = sfRenderWindow_create(mode, 
-												   "Programa 2: Triangulo de Sierpinski", 
-												   sfResize | sfClose, 
+	double vertices[3][2];
+	int Alpha = 90, diferencia = 360 / 3;
+	for (int i = 0; i < 3; i++, Alpha += diferencia) {
+		vertices[i][0] = (int)(348 * cos(Alpha * Radian)) + 683;
+		vertices[i][1] = (int)(-348 * sin(Alpha * Radian)) + 352;
+	}
+	if (en_pixeles)
+		ifs_triangulo(&caos.sistema.ifs, vertices);
+
+	if (salida != NULL) {
+		if (ancho <= 0 || alto <= 0 || (unsigned long long)ancho * alto >= UINT32_MAX || hilos <= 0) {
+			printf("Error: tamano de imagen o numero de hilos invalido.\n");
+			return 1;
+		}
+		if (renderizar(&caos.sistema, !en_pixeles, ancho, alto, hilos, puntos,
+		               caos.semilla, salida) != 0) {
+			printf("Error: no se pudo generar %s.\n", salida);
+			return 1;
+		}
+		return 0;
+	}
+
+	char titulo[128];
+	if (lados > 0)
+		snprintf(titulo, sizeof(titulo), "Programa 2: Juego del caos, %d lados, razon %g, regla %s",
+		         lados, razon, nombre_regla);
+	else
+		snprintf(titulo, sizeof(titulo), "Programa 2: %s",
+		         archivo_ifs != NULL ? archivo_ifs : "Triangulo de Sierpinski");
+
+	sfVideoMode mode = {ANCHO, ALTO, 32};
+	sfRenderWindow *window = sfRenderWindow_create(mode,
+												   titulo,
+												   sfResize | sfClose,
 												   sfWindowed, NULL);
-	sfVector2f v, u;
+	sfVector2f v;
 	sfVertex tmp;
 	tmp.color = sfGreen;
-	int x, y, step = 0, Alpha = 90, diferencia = 360 / 3;
 	sfVertexArray *triangle = sfVertexArray_create();
 	sfVertexArray_setPrimitiveType(triangle, sfLineStrip);
-	for(int i = 0; i < 4; i++){
-		x = (int)(348 * cos(Alpha * Radian)) + 683;
-		y = (int)(-348 * sin(Alpha * Radian)) + 352;
-		v.x = x;
-		v.y = y;
+	for(int i = 0; i < 4 && en_pixeles; i++){
+		v.x = vertices[i % 3][0];
+		v.y = vertices[i % 3][1];
 		tmp.position = v;
 		sfVertexArray_append(triangle,tmp);
-		Alpha += diferencia;
-	}
-	 
-	
-	x = 683;
-	y = 352;
-	
-	sfVertexArray *points = sfVertexArray_create();
-	sfVertexArray_setPrimitiveType(points, sfPoints);
+	}
+
+	if (en_pixeles)
+		caos.escala[0] = caos.escala[1] = 1;
+	else {
+		Orbitas *prueba = aligned_alloc(64, sizeof(Orbitas));
+		double caja[4];
+		if (prueba == NULL) {
+			printf("Error: memoria insuficiente.\n");
+			return 1;
+		}
+		orbitas_iniciar(prueba, caos.semilla, 0);
+		medir_caja(&caos.sistema, prueba, caja);
+		ajustar_vista(caos.escala, caos.origen, caja, ANCHO, ALTO, 1);
+		free(prueba);
+	}
+
+	// Contorno del poligono, llevado a pixeles con la misma vista
+	for (int i = 0; lados > 0 && i <= lados; i++) {
+		v.x = caos.sistema.juego.vx[i % lados] * caos.escala[0] + caos.origen[0];
+		v.y = caos.sistema.juego.vy[i % lados] * caos.escala[1] + caos.origen[1];
+		tmp.position = v;
+		sfVertexArray_append(triangle, tmp);
+	}
+
+	caos.densidad = calloc(ANCHO * ALTO + 1, sizeof(uint32_t));
+	caos.buffers[0] = calloc(ANCHO * ALTO, sizeof(uint32_t));
+	caos.buffers[1] = calloc(ANCHO * ALTO, sizeof(uint32_t));
+	uint8_t *pixeles = malloc(ANCHO * ALTO * 4);
+	if (caos.densidad == NULL || caos.buffers[0] == NULL || caos.buffers[1] == NULL || pixeles == NULL) {
+		printf("Error: memoria insuficiente.\n");
+		return 1;
+	}
+	sfTexture *textura = sfTexture_create((sfVector2u){ANCHO, ALTO});
+	sfSprite *imagen = sfSprite_create(textura);
+
+	pthread_t trabajador;
+	pthread_create(&trabajador, NULL, iterar, &caos);
+
+	double ultimo = segundos();
+	unsigned long long previas = 0;
+	char encabezado[256];
+
 	while (sfRenderWindow_isOpen(window)) {
 		sfEvent event;
 		while (sfRenderWindow_pollEvent(window, &event)) {
 			if (event.type == sfEvtClosed) sfRenderWindow_close(window);
 		}
-		v.x = x;
-		v.y = y;
-		tmp.position = v;
-		sfVertexArray_append(points,tmp);
-		
-		if(step < 1000000){
-			int r = rand() % 3;
-			x = (int) ((x + 
-					   sfVertexArray_getVertex(triangle, r) -> position.x) / 2);
-			y = (int) ((y + 
-					   sfVertexArray_getVertex(triangle, r) -> position.y) / 2);
-		}
-		
-		step++;
+
+		if (atomic_load(&caos.nuevo)) {
+			int frente = atomic_load(&caos.frente);
+			tono_logaritmico(caos.buffers[frente], caos.maximos[frente], pixeles);
+			atomic_store(&caos.nuevo, 0);
+			sfTexture_updateFromPixels(textura, pixeles, (sfVector2u){ANCHO, ALTO},
+									   (sfVector2u){0, 0});
+		}
+
+		// Contador de rendimiento en el titulo, dos veces por segundo
+		double ahora = segundos();
+		if (ahora - ultimo >= 0.5) {
+			unsigned long long hechas = atomic_load(&caos.iteraciones);
+			double dimension = atomic_load(&caos.dimension);
+			int nivel = atomic_load(&caos.nivel);
+			if (isnan(dimension))
+				snprintf(encabezado, sizeof(encabezado), "%s - %.2f M it/s - %llu puntos - D = ?",
+						 titulo, (hechas - previas) / (ahora - ultimo) / 1e6, hechas);
+			else
+				snprintf(encabezado, sizeof(encabezado),
+						 "%s - %.2f M it/s - %llu puntos - D = %.4f (cajas 2^%d a 2^%d)",
+						 titulo, (hechas - previas) / (ahora - ultimo) / 1e6, hechas,
+						 dimension, NIVEL_MINIMO_AJUSTE, nivel);
+			sfRenderWindow_setTitle(window, encabezado);
+			previas = hechas;
+			ultimo = ahora;
+		}
+
 		sfRenderWindow_clear(window, sfBlack);
+		sfRenderWindow_drawSprite(window, imagen, NULL);
 		sfRenderWindow_drawVertexArray(window, triangle, NULL);
-		sfRenderWindow_drawVertexArray(window, points, NULL);
 		sfRenderWindow_display(window);
 		}
-	
+
+	atomic_store(&caos.terminar, 1);
+	pthread_join(trabajador, NULL);
+
+	sfSprite_destroy(imagen);
+	sfTexture_destroy(textura);
+	free(caos.densidad);
+	free(caos.buffers[0]);
+	free(caos.buffers[1]);
+	free(pixeles);
 	sfVertexArray_destroy(triangle);
-	sfVertexArray_destroy(points);
 	sfRenderWindow_destroy(window);
 
 	return 0;